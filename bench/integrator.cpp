@@ -0,0 +1,137 @@
+/**
+ * Replays recorded tracking wheel traces through each odometry integrator and
+ * prints how far each one drifts from the known end pose. Runs on the host:
+ *
+ *   g++ -std=gnu++17 -O2 -Iinclude bench/integrator.cpp -o integrator_bench
+ *   ./integrator_bench bench/traces/weave.csv
+ *
+ * A trace is a csv of the time in milliseconds and the left, right and middle
+ * tracking wheel distances in inches, one row per odometry update. Comment
+ * lines give the tracking wheel layout and the pose the robot ended at:
+ *
+ *   # track_width 10
+ *   # middle_distance 2
+ *   # end <x> <y> <degrees counterclockwise>
+ *
+ * A trace can be recorded on the robot by printing odom::getLeftEncoder() and
+ * the others divided by their tpi from the odometry task, with the end pose
+ * measured on the field.
+ */
+#include "ARMS/integrator.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace arms;
+using namespace arms::odom;
+
+typedef struct sample_s {
+	double time;
+	double left;
+	double right;
+	double middle;
+} sample_s_t;
+
+typedef struct trace_s {
+	double track_width = 0;
+	double middle_distance = 0;
+	double end[3] = {0, 0, 0}; // x, y, degrees
+	std::vector<sample_s_t> samples;
+} trace_s_t;
+
+bool load(const char* file, trace_s_t& trace) {
+	FILE* f = fopen(file, "r");
+	if (!f) {
+		printf("ERROR: could not open %s\n", file);
+		return false;
+	}
+
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		sample_s_t s;
+		if (line[0] == '#') {
+			sscanf(line, "# track_width %lf", &trace.track_width);
+			sscanf(line, "# middle_distance %lf", &trace.middle_distance);
+			sscanf(line, "# end %lf %lf %lf", &trace.end[0], &trace.end[1],
+			       &trace.end[2]);
+		} else if (sscanf(line, "%lf,%lf,%lf,%lf", &s.time, &s.left, &s.right,
+		                  &s.middle) == 4) {
+			trace.samples.push_back(s);
+		}
+	}
+	fclose(f);
+
+	if (trace.samples.size() < 2 || trace.track_width <= 0) {
+		printf("ERROR: %s needs a track width and at least two samples\n", file);
+		return false;
+	}
+	return true;
+}
+
+// replay the trace the way odom::update() integrates the encoders, returns
+// the end pose with the heading in radians
+std::array<double, 3> replay(const trace_s_t& trace,
+                             Integrator_e_t integrator) {
+	double x = 0;
+	double y = 0;
+	double heading = 0;
+	for (size_t i = 1; i < trace.samples.size(); i++) {
+		const sample_s_t& a = trace.samples[i - 1];
+		const sample_s_t& b = trace.samples[i];
+		double delta_left = b.left - a.left;
+		double delta_right = b.right - a.right;
+		double delta_middle = b.middle - a.middle;
+
+		double delta_angle = (delta_right - delta_left) / trace.track_width;
+		double forward = delta_right - trace.track_width / 2 * delta_angle;
+		double left = delta_middle + trace.middle_distance * delta_angle;
+
+		Point delta = integrate(integrator, forward, left, delta_angle, heading);
+		x += delta.x;
+		y += delta.y;
+		heading += delta_angle;
+	}
+	return {x, y, heading};
+}
+
+int main(int argc, char** argv) {
+	const char* file = argc > 1 ? argv[1] : "bench/traces/weave.csv";
+	trace_s_t trace;
+	if (!load(file, trace))
+		return 1;
+
+	const sample_s_t& last = trace.samples.back();
+	printf("%s: %zu samples over %.1f s, end (%.3f, %.3f, %.2f deg)\n", file,
+	       trace.samples.size(), (last.time - trace.samples[0].time) / 1000,
+	       trace.end[0], trace.end[1], trace.end[2]);
+	printf("%-12s %14s %14s %10s\n", "integrator", "position (in)",
+	       "heading (deg)", "ns/step");
+
+	const char* names[] = {"ARC", "RK2", "EXPONENTIAL"};
+	Integrator_e_t integrators[] = {INTEGRATOR_ARC, INTEGRATOR_RK2,
+	                                INTEGRATOR_EXPONENTIAL};
+	for (int i = 0; i < 3; i++) {
+		std::array<double, 3> pose = replay(trace, integrators[i]);
+
+		// time enough replays to get past the clock resolution
+		const int repeats = 200;
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < repeats; n++) {
+			std::array<double, 3> p = replay(trace, integrators[i]);
+			asm volatile("" : : "g"(&p) : "memory");
+		}
+		double elapsed = std::chrono::duration<double, std::nano>(
+		                     std::chrono::steady_clock::now() - start)
+		                     .count();
+
+		double dx = pose[0] - trace.end[0];
+		double dy = pose[1] - trace.end[1];
+		double dtheta = pose[2] * 180 / M_PI - trace.end[2];
+		printf("%-12s %14.6f %14.6f %10.1f\n", names[i], sqrt(dx * dx + dy * dy),
+		       fabs(dtheta), elapsed / repeats / (trace.samples.size() - 1));
+	}
+	return 0;
+}
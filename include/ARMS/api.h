@@ -1,8 +1,18 @@
 #pragma once
 
+#include "ARMS/bake.h"
+#include "ARMS/calibration.h"
+#include "ARMS/characterization.h"
 #include "ARMS/chassis.h"
+#include "ARMS/ekf.h"
 #include "ARMS/flags.h"
+#include "ARMS/mcl.h"
 #include "ARMS/odom.h"
+#include "ARMS/path.h"
 #include "ARMS/pid.h"
 #include "ARMS/point.h"
+#include "ARMS/profile.h"
+#include "ARMS/pursuit.h"
+#include "ARMS/ramsete.h"
+#include "ARMS/scheduler.h"
 #include "ARMS/selector.h"
@@ -0,0 +1,389 @@
+#ifndef _ARMS_BAKE_H_
+#define _ARMS_BAKE_H_
+
+#include "ARMS/path.h"
+#include "ARMS/point.h"
+#include "ARMS/pursuit.h"
+#include "ARMS/ramsete.h"
+#include <array>
+#include <cstddef>
+
+/**
+ * Path and trajectory generation usable in a constant expression, so a path
+ * that is fixed when the program is built can be sampled by the compiler:
+ *
+ *   static constexpr auto curve = arms::bake::path<100>(
+ *       arms::SPLINE_QUINTIC_HERMITE, {{0, 0, 0}, {48, 24, 90}});
+ *   static constexpr auto drive =
+ *       arms::bake::trajectory(curve, 50, PURSUIT_ACCEL, PURSUIT_TURN_RATE);
+ *
+ *   arms::chassis::followTrajectory(drive.data(), drive.size());
+ *
+ * Declared static constexpr, or at namespace scope, the tables are stored in
+ * flash and nothing is generated when the program starts. Path, pursuit and
+ * ramsete generate their tables at runtime with the same code.
+ */
+namespace arms::bake {
+
+/**************************************************/
+// math, the <cmath> functions can not be used in a constant expression
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double abs(double x) {
+	return x < 0 ? -x : x;
+}
+
+constexpr double round(double x) {
+	return x < 0 ? -(double)(long long)(0.5 - x) : (double)(long long)(x + 0.5);
+}
+
+constexpr double sqrt(double x) {
+	if (x <= 0)
+		return 0;
+
+	// newton's method falls monotonically from any start above the root
+	double root = x > 1 ? x : 1;
+	for (int i = 0; i < 1100; i++) {
+		double next = (root + x / root) / 2;
+		if (next >= root)
+			break;
+		root = next;
+	}
+	return root;
+}
+
+constexpr double sin(double x) {
+	// reduce to [-pi/2, pi/2] where the series converges quickly
+	x -= 2 * PI * round(x / (2 * PI));
+	if (x > PI / 2)
+		x = PI - x;
+	else if (x < -PI / 2)
+		x = -PI - x;
+
+	double term = x;
+	double sum = x;
+	for (int n = 1; n < 12; n++) {
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double cos(double x) {
+	return sin(x + PI / 2);
+}
+
+constexpr double atan(double x) {
+	if (x < 0)
+		return -atan(-x);
+	if (x > 1)
+		return PI / 2 - atan(1 / x);
+
+	// halve the angle twice, then the series converges quickly
+	x = x / (1 + sqrt(1 + x * x));
+	x = x / (1 + sqrt(1 + x * x));
+	double term = x;
+	double sum = x;
+	for (int n = 1; n < 16; n++) {
+		term *= -x * x;
+		sum += term / (2 * n + 1);
+	}
+	return 4 * sum;
+}
+
+constexpr double atan2(double y, double x) {
+	if (x > 0)
+		return atan(y / x);
+	if (x < 0)
+		return y >= 0 ? atan(y / x) + PI : atan(y / x) - PI;
+	return y > 0 ? PI / 2 : (y < 0 ? -PI / 2 : 0);
+}
+
+/**************************************************/
+// splines
+
+// steps per segment when measuring the arc length
+constexpr int SUBDIVISIONS = 100;
+
+// polynomial in t from 0 to 1, coefficients from the constant term up
+typedef struct segment_s {
+	double x[6];
+	double y[6];
+} segment_s_t;
+
+constexpr segment_s_t hermite(SplineType_e_t type, waypoint_s_t a,
+                              waypoint_s_t b) {
+	double length = sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+	double p0[2] = {a.x, a.y};
+	double p1[2] = {b.x, b.y};
+	double m0[2] = {length * cos(a.theta * PI / 180),
+	                length * sin(a.theta * PI / 180)};
+	double m1[2] = {length * cos(b.theta * PI / 180),
+	                length * sin(b.theta * PI / 180)};
+
+	segment_s_t segment = {};
+	for (int d = 0; d < 2; d++) {
+		double* c = d ? segment.y : segment.x;
+		c[0] = p0[d];
+		c[1] = m0[d];
+		if (type == SPLINE_QUINTIC_HERMITE) {
+			// zero second derivative at both ends
+			c[3] = -10 * p0[d] - 6 * m0[d] - 4 * m1[d] + 10 * p1[d];
+			c[4] = 15 * p0[d] + 8 * m0[d] + 7 * m1[d] - 15 * p1[d];
+			c[5] = -6 * p0[d] - 3 * m0[d] - 3 * m1[d] + 6 * p1[d];
+		} else {
+			c[2] = -3 * p0[d] - 2 * m0[d] + 3 * p1[d] - m1[d];
+			c[3] = 2 * p0[d] + m0[d] - 2 * p1[d] + m1[d];
+		}
+	}
+	return segment;
+}
+
+constexpr segment_s_t bezier(Point b0, Point b1, Point b2, Point b3) {
+	double p[4][2] = {{b0.x, b0.y}, {b1.x, b1.y}, {b2.x, b2.y}, {b3.x, b3.y}};
+	segment_s_t segment = {};
+	for (int d = 0; d < 2; d++) {
+		double* c = d ? segment.y : segment.x;
+		c[0] = p[0][d];
+		c[1] = 3 * (p[1][d] - p[0][d]);
+		c[2] = 3 * (p[0][d] - 2 * p[1][d] + p[2][d]);
+		c[3] = -p[0][d] + 3 * p[1][d] - 3 * p[2][d] + p[3][d];
+	}
+	return segment;
+}
+
+// position, first and second derivative of a segment
+constexpr void evaluate(const segment_s_t& segment, double t,
+                        double out[3][2]) {
+	for (int d = 0; d < 2; d++) {
+		const double* c = d ? segment.y : segment.x;
+		out[0][d] = 0;
+		out[1][d] = 0;
+		out[2][d] = 0;
+		for (int i = 5; i >= 0; i--) {
+			out[0][d] = out[0][d] * t + c[i];
+			if (i >= 1)
+				out[1][d] = out[1][d] * t + i * c[i];
+			if (i >= 2)
+				out[2][d] = out[2][d] * t + i * (i - 1) * c[i];
+		}
+	}
+}
+
+// length of one measuring step along the segments
+constexpr double stepLength(const segment_s_t* segments, int step) {
+	double a[3][2] = {};
+	double b[3][2] = {};
+	const segment_s_t& segment = segments[step / SUBDIVISIONS];
+	evaluate(segment, (double)(step % SUBDIVISIONS) / SUBDIVISIONS, a);
+	evaluate(segment, (double)(step % SUBDIVISIONS + 1) / SUBDIVISIONS, b);
+	double dx = b[0][0] - a[0][0];
+	double dy = b[0][1] - a[0][1];
+	return sqrt(dx * dx + dy * dy);
+}
+
+// length of the joined segments
+constexpr double measure(const segment_s_t* segments, int count) {
+	double length = 0;
+	for (int k = 0; k < count * SUBDIVISIONS; k++)
+		length += stepLength(segments, k);
+	return length;
+}
+
+/**
+ * Sample the joined segments every spacing inches of arc length into out. The
+ * last entry is at the end of the path even when it is less than spacing from
+ * the one before.
+ */
+constexpr void tabulate(const segment_s_t* segments, int segment_count,
+                        double spacing, path_sample_s_t* out, int count) {
+	int steps = segment_count * SUBDIVISIONS;
+	double total = measure(segments, segment_count);
+
+	int k = 0;                // measuring step
+	double start = 0;         // length to the start of the step
+	double length = stepLength(segments, 0);
+	double theta = 0;
+	for (int i = 0; i < count; i++) {
+		double distance = i * spacing < total ? i * spacing : total;
+		if (i == count - 1)
+			distance = total;
+		while (k < steps - 1 && start + length < distance) {
+			start += length;
+			k++;
+			length = stepLength(segments, k);
+		}
+
+		// parameter of the distance, interpolated within the step
+		double fraction = length > 0 ? (distance - start) / length : 0;
+		fraction = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction);
+		double t = (k % SUBDIVISIONS + fraction) / SUBDIVISIONS;
+
+		double p[3][2] = {};
+		evaluate(segments[k / SUBDIVISIONS], t, p);
+		double speed = sqrt(p[1][0] * p[1][0] + p[1][1] * p[1][1]);
+		double curvature = 0;
+		if (speed > 1e-9) {
+			// keep the heading continuous with the last entry
+			double heading = atan2(p[1][1], p[1][0]);
+			if (i > 0)
+				heading += 2 * PI * round((theta - heading) / (2 * PI));
+			theta = heading;
+			double cross = p[1][0] * p[2][1] - p[1][1] * p[2][0];
+			curvature = cross / (speed * speed * speed);
+		}
+		out[i] = {distance, p[0][0], p[0][1], theta, curvature};
+	}
+}
+
+/**************************************************/
+// velocity planning
+
+/**
+ * Set the target velocity of each path point: limited by turn_rate around
+ * curves and by acceleration to a stop at the end, and from rest at the start
+ * if from_rest is set. The points need distance, curvature and velocity.
+ */
+template <typename T>
+constexpr void plan(T* points, int count, double max_velocity,
+                    double turn_rate, double acceleration, bool from_rest) {
+	for (int i = 0; i < count; i++) {
+		double k = abs(points[i].curvature);
+		points[i].velocity = k > 0 && turn_rate / k < max_velocity
+		                         ? turn_rate / k
+		                         : max_velocity;
+	}
+
+	if (from_rest) {
+		points[0].velocity = 0;
+		for (int i = 1; i < count; i++) {
+			double d = points[i].distance - points[i - 1].distance;
+			double v = points[i - 1].velocity;
+			double reachable = sqrt(v * v + 2 * acceleration * d);
+			if (reachable < points[i].velocity)
+				points[i].velocity = reachable;
+		}
+	}
+
+	points[count - 1].velocity = 0;
+	for (int i = count - 2; i >= 0; i--) {
+		double d = points[i + 1].distance - points[i].distance;
+		double v = points[i + 1].velocity;
+		double stoppable = sqrt(v * v + 2 * acceleration * d);
+		if (stoppable < points[i].velocity)
+			points[i].velocity = stoppable;
+	}
+}
+
+/**
+ * Time a planned path into a trajectory, driving backwards if reverse is set.
+ * The heading comes from the spline table when there is one and from the
+ * neighbouring points otherwise.
+ */
+template <typename T>
+constexpr void time(const T* points, int count, bool reverse,
+                    const path_sample_s_t* spline,
+                    ramsete::trajectory_point_s_t* out) {
+	double direction = reverse ? -1 : 1;
+	double time = 0;
+	double prev_theta = 0;
+	for (int i = 0; i < count; i++) {
+		const T& p = points[i];
+
+		// time to the point at a constant acceleration from the last one
+		if (i > 0) {
+			double d = p.distance - points[i - 1].distance;
+			double v = p.velocity + points[i - 1].velocity;
+			if (v > 0)
+				time += 2 * d / v;
+		}
+
+		// tangent, kept continuous
+		const T& a = points[i > 0 ? i - 1 : 0];
+		const T& c = points[i < count - 1 ? i + 1 : count - 1];
+		double theta = spline ? spline[i].theta : atan2(c.y - a.y, c.x - a.x);
+		theta += reverse ? PI : 0;
+		if (i > 0)
+			theta += 2 * PI * round((prev_theta - theta) / (2 * PI));
+		prev_theta = theta;
+
+		out[i] = {time, p.x, p.y, theta, direction * p.velocity,
+		          p.velocity * p.curvature, 0};
+	}
+
+	// acceleration between each point and the next
+	for (int i = 0; i < count - 1; i++) {
+		double dt = out[i + 1].time - out[i].time;
+		if (dt > 0)
+			out[i].acceleration = (out[i + 1].velocity - out[i].velocity) / dt;
+	}
+}
+
+/**************************************************/
+// baking
+
+/**
+ * Join a list of poses with hermite splines, as Path does, into a table of N
+ * entries evenly spaced along the path
+ */
+template <size_t N, size_t W>
+constexpr std::array<path_sample_s_t, N>
+path(SplineType_e_t type, const waypoint_s_t (&waypoints)[W]) {
+	static_assert(N >= 2, "a path table needs at least two entries");
+	static_assert(W >= 2, "a spline needs at least two waypoints");
+
+	std::array<segment_s_t, W - 1> segments = {};
+	for (size_t i = 0; i + 1 < W; i++)
+		segments[i] = hermite(type, waypoints[i], waypoints[i + 1]);
+
+	std::array<path_sample_s_t, N> table = {};
+	double length = measure(segments.data(), W - 1);
+	tabulate(segments.data(), W - 1, length / (N - 1), table.data(), N);
+	return table;
+}
+
+/**
+ * Join cubic bezier curves through 3n + 1 control points, as Path does, into
+ * a table of N entries evenly spaced along the path
+ */
+template <size_t N, size_t C>
+constexpr std::array<path_sample_s_t, N> path(const Point (&control)[C]) {
+	static_assert(N >= 2, "a path table needs at least two entries");
+	static_assert(C >= 4 && (C - 1) % 3 == 0,
+	              "a bezier path needs 3n + 1 control points");
+
+	std::array<segment_s_t, (C - 1) / 3> segments = {};
+	for (size_t i = 0; i + 3 < C; i += 3)
+		segments[i / 3] =
+		    bezier(control[i], control[i + 1], control[i + 2], control[i + 3]);
+
+	std::array<path_sample_s_t, N> table = {};
+	double length = measure(segments.data(), (C - 1) / 3);
+	tabulate(segments.data(), (C - 1) / 3, length / (N - 1), table.data(), N);
+	return table;
+}
+
+/**
+ * Time a baked path into a trajectory for ramsete, as ramsete::generate()
+ * does. Velocities are in the units of chassis::getMaxVelocity(), which must
+ * be known when the program is built, and turn_rate is in radians per second.
+ */
+template <size_t N>
+constexpr std::array<ramsete::trajectory_point_s_t, N>
+trajectory(const std::array<path_sample_s_t, N>& path, double max_velocity,
+           double acceleration, double turn_rate, bool reverse = false) {
+	std::array<pursuit::path_point_s_t, N> points = {};
+	for (size_t i = 0; i < N; i++)
+		points[i] = {path[i].x, path[i].y, path[i].distance, path[i].curvature,
+		             0};
+	plan(points.data(), N, max_velocity, turn_rate, acceleration, true);
+
+	std::array<ramsete::trajectory_point_s_t, N> out = {};
+	time(points.data(), N, reverse, path.data(), out.data());
+	return out;
+}
+
+} // namespace arms::bake
+
+#endif
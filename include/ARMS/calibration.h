@@ -0,0 +1,30 @@
+#ifndef _ARMS_CALIBRATION_H_
+#define _ARMS_CALIBRATION_H_
+
+namespace arms::calibration {
+
+/**
+ * Calibrate the tracking wheels. The routine is guided from the terminal and
+ * the master controller:
+ *
+ * 1. push the robot straight forward exactly distance inches, for TPI
+ * 2. push it straight left exactly distance inches, for MIDDLE_TPI
+ * 3. the robot spins in place turns times each way while the IMU measures the
+ *    rotation, for TRACK_WIDTH and MIDDLE_DISTANCE
+ *
+ * Press A on the controller to start and end each push. Step 2 is skipped
+ * without a middle wheel and step 3 without an IMU. The results are applied to
+ * the odometry, printed to the terminal and written to the SD card. If the IMU
+ * stops responding during a spin nothing is applied.
+ */
+void run(double distance = 48, int turns = 5, double voltage = 6);
+
+/**
+ * Apply the tracking wheel constants saved on the SD card by run(), returns
+ * false if there are none
+ */
+bool load();
+
+} // namespace arms::calibration
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _ARMS_CHARACTERIZATION_H_
+#define _ARMS_CHARACTERIZATION_H_
+
+namespace arms::characterization {
+
+// Feedforward gains fit to the logged data
+typedef struct fit_s {
+	double kS = 0; // volts
+	double kV = 0; // volts per unit of chassis::getMaxVelocity()
+	double kA = 0; // volts per unit of acceleration
+	double r2 = 0; // coefficient of determination of the fit
+	int samples = 0;
+} fit_s_t;
+
+/**
+ * Characterize the drivetrain. The robot runs a quasistatic voltage ramp and
+ * a voltage step, forwards and then backwards, while logging the voltage,
+ * velocity and acceleration of each side. kS, kV and kA are fit by least
+ * squares, printed to the terminal and written to the SD card.
+ *
+ * The robot needs max_distance inches of clear space in front and behind it.
+ */
+void run(double ramp_rate = 0.25, double step_voltage = 6,
+         double max_distance = 48);
+
+/**
+ * Return the fit of the last characterization for a side (0 left, 1 right)
+ */
+fit_s_t getFit(int side);
+
+} // namespace arms::characterization
+
+#endif
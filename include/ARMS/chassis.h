@@ -3,16 +3,40 @@
 
 #include "../api.h"
 #include "ARMS/flags.h"
+#include "ARMS/path.h"
 #include "ARMS/point.h"
+#include "ARMS/profile.h"
+#include "ARMS/ramsete.h"
+#include "ARMS/scheduler.h"
 #include <memory>
 
 namespace arms::chassis {
 
+// Drivetrain layout
+typedef enum ChassisType {
+	DIFFERENTIAL, // left and right sides
+	X_DRIVE,      // four corner wheels at 45 degrees
+	MECANUM,      // four corner mecanum wheels
+	H_DRIVE       // left and right sides with a strafing center wheel
+} ChassisType_e_t;
+
+// Controller used for velocity control
+typedef enum VelocityMode {
+	VELOCITY_INTERNAL, // the velocity controller built into the motors
+	VELOCITY_ARMS      // feedforward and feedback on the measured speed
+} VelocityMode_e_t;
+
 extern double maxSpeed;
 extern double min_linear_speed;
 extern double min_angular_speed;
 extern std::shared_ptr<pros::Motor_Group> leftMotors;
 extern std::shared_ptr<pros::Motor_Group> rightMotors;
+extern std::shared_ptr<pros::Motor_Group> frontLeftMotors;
+extern std::shared_ptr<pros::Motor_Group> frontRightMotors;
+extern std::shared_ptr<pros::Motor_Group> backLeftMotors;
+extern std::shared_ptr<pros::Motor_Group> backRightMotors;
+// center wheel of an h-drive, positive output drives the robot to the left
+extern std::shared_ptr<pros::Motor_Group> strafeMotors;
 
 /**
  * Set the brake mode for all chassis motors
@@ -25,9 +49,10 @@ void setBrakeMode(pros::motor_brake_mode_e_t b);
 bool settled();
 
 /**
- * Wait for the chassis to complete the current movement
+ * Wait for the chassis to complete the current movement, returns false if the
+ * timeout in milliseconds runs out first
  */
-void waitUntilFinished(double exit_error);
+bool waitUntilFinished(double exit_error, uint32_t timeout = TIMEOUT_MAX);
 
 /**
  * Perform 2D chassis movement
@@ -66,6 +91,40 @@ void turn(Point target, double max, double exit_error, MoveFlags = NONE);
 void turn(Point target, double max, MoveFlags = NONE);
 void turn(Point target, MoveFlags = NONE);
 
+/**
+ * Follow a path with pure pursuit, either through a list of waypoints in field
+ * coordinates starting from the current position or along a spline path. The
+ * path is slowed around curves, see pursuit::generate(). Only differential
+ * chassis with a drive width are supported.
+ */
+void follow(std::vector<Point> path, double max, double exit_error,
+            MoveFlags = NONE);
+void follow(std::vector<Point> path, double max, MoveFlags = NONE);
+void follow(std::vector<Point> path, MoveFlags = NONE);
+void follow(const Path& path, double max, double exit_error, MoveFlags = NONE);
+void follow(const Path& path, double max, MoveFlags = NONE);
+void follow(const Path& path, MoveFlags = NONE);
+
+/**
+ * Track a time parameterised trajectory with a RAMSETE controller. The
+ * trajectory is either generated from the current position through a list of
+ * waypoints or along a spline path, see ramsete::generate(), or is a table of
+ * points in field coordinates that must stay valid until the movement is
+ * finished. Only differential chassis with a drive width are supported.
+ */
+void followTrajectory(std::vector<Point> path, double max, double exit_error,
+                      MoveFlags = NONE);
+void followTrajectory(std::vector<Point> path, double max, MoveFlags = NONE);
+void followTrajectory(std::vector<Point> path, MoveFlags = NONE);
+void followTrajectory(const Path& path, double max, double exit_error,
+                      MoveFlags = NONE);
+void followTrajectory(const Path& path, double max, MoveFlags = NONE);
+void followTrajectory(const Path& path, MoveFlags = NONE);
+void followTrajectory(const ramsete::trajectory_point_s_t* trajectory,
+                      int size, double exit_error, MoveFlags = NONE);
+void followTrajectory(const ramsete::trajectory_point_s_t* trajectory,
+                      int size, MoveFlags = NONE);
+
 void moveVectorEnd(double magnitude, double angle, double max, double exit_error,
                    double lp, double ap, MoveFlags = NONE);
 void moveVectorEnd(double magnitude, double angle, double max, double exit_error,
@@ -83,15 +142,76 @@ void moveVectorPath(double magnitude, double angle, MoveFlags = NONE);
 
 
 /**
- * Assign a power to the left and right motors
+ * Set the reference wheel velocities and accelerations {left, right} of the
+ * current motion, used by the feedforward. Starting a movement clears them.
+ */
+void setReference(std::array<double, 2> velocity,
+                  std::array<double, 2> acceleration);
+
+/**
+ * Return the wheel speed at full power in inches per second, or 100 when the
+ * wheel diameter is not configured
+ */
+double getMaxVelocity();
+
+/**
+ * Return the filtered battery voltage in volts
+ */
+double getBatteryVoltage();
+
+/**
+ * Return the distance between the left and right drive wheels in inches, 0
+ * when it is not configured
+ */
+double getDriveWidth();
+
+/**
+ * Return the voltage left before the chassis motor output saturates, negative
+ * values are the voltage that was clipped
+ */
+double getHeadroom();
+
+/**
+ * Return the measured wheel velocities {left, right} in the units of
+ * getMaxVelocity()
+ */
+std::array<double, 2> getWheelVelocity();
+
+/**
+ * Assign a power to the left and right motors. With velocity control the
+ * speeds are wheel speeds in the units of getMaxVelocity().
  */
 void tank(double left, double right, bool velocity = false);
 
 /**
- * Assign a vertical and horizontal power to the motors
+ * Assign a vertical and horizontal power to the motors. With velocity control
+ * the speeds are wheel speeds in the units of getMaxVelocity().
  */
 void arcade(double vertical, double horizontal, bool velocity = false);
 
+/**
+ * Assign a forward, strafe (positive right) and turn (positive clockwise)
+ * power to a holonomic chassis. Field centric control drives relative to the
+ * field instead of the robot, using the odometry heading.
+ */
+void holonomic(double forward, double strafe, double turn,
+               bool fieldCentric = false, bool velocity = false);
+
+/**
+ * Return the measured timing of the chassis task
+ */
+loop_stats_s_t getLoopStats();
+
+/**
+ * Return the time spent in pid::translational() and pid::angular()
+ */
+time_stats_s_t getControllerStats();
+
+/**
+ * Clear the chassis task and controller timing
+ */
+void resetLoopStats();
+
 /**
  * initialize the chassis
  */
@@ -100,7 +220,20 @@ void init(std::initializer_list<int8_t> leftMotors,
           pros::motor_gearset_e_t gearset, double slew_step,
           double linear_exit_error, double angular_exit_error,
           double settle_thresh_linear, double settle_thresh_angular,
-          int settle_time, double min_linear_speed, double min_angular_speed);
+          int settle_time, double min_linear_speed, double min_angular_speed,
+          int period = 10, bool timing_debug = false,
+          double wheel_diameter = 0, double gear_ratio = 1,
+          VelocityMode_e_t velocity_mode = VELOCITY_INTERNAL,
+          double velocity_kp = 0,
+          std::array<double, 3> left_feedforward = {0, 0, 0},
+          std::array<double, 3> right_feedforward = {0, 0, 0},
+          bool battery_compensation = false, double nominal_voltage = 12,
+          ChassisType_e_t type = DIFFERENTIAL,
+          std::initializer_list<int8_t> strafeMotors = {},
+          ProfileType_e_t profile_type = PROFILE_NONE,
+          double profile_accel = 0, double profile_jerk = 0,
+          double profile_angular_accel = 0, double profile_angular_jerk = 0,
+          double drive_width = 0);
 
 } // namespace arms::chassis
 
@@ -7,15 +7,21 @@ namespace arms {
 
 // Debug
 #define ODOM_DEBUG 0
+#define TIMING_DEBUG 0 // Print control loop timing every second (1 or 0)
 
 // Negative numbers mean reversed motor
+// For X-drive and mecanum list the front motors of each side first
 #define LEFT_MOTORS 1, 2
 #define RIGHT_MOTORS -3, -4
 #define GEARSET pros::E_MOTOR_GEAR_200 // RPM of chassis motors
+#define CHASSIS_TYPE                                                           \
+	arms::chassis::DIFFERENTIAL // DIFFERENTIAL, X_DRIVE, MECANUM or H_DRIVE
+#define STRAFE_MOTORS // Center wheel motors of an H-drive, forward drives left
 
 // Ticks per inch
-#define TPI 1        // Encoder ticks per inch of forward robot movement
-#define MIDDLE_TPI 1 // Ticks per inch for the middle wheel
+#define TPI 1              // Encoder ticks per inch of forward robot movement
+#define MIDDLE_TPI 1       // Ticks per inch for the middle wheel
+#define LOAD_CALIBRATION 0 // Use calibration::run() results on SD (1 or 0)
 
 // Tracking wheel distances
 #define TRACK_WIDTH                                                            \
@@ -25,9 +31,28 @@ namespace arms {
 
 // Sensors
 #define IMU_PORT 0                           // Port 0 for disabled
+#define EXTRA_IMU_PORTS                      // More IMUs to fuse with the first
 #define ENCODER_PORTS 0, 0, 0                // Port 0 for disabled,
 #define EXPANDER_PORT 0                      // Port 0 for disabled
 #define ENCODER_TYPE arms::odom::ENCODER_ADI // The type of encoders
+#define MOTOR_ENCODER_MODE                                                     \
+	arms::odom::MOTOR_ENCODER_FIRST // Motor encoder filter: FIRST, MEAN or MEDIAN
+#define ODOM_INTEGRATOR                                                        \
+	arms::odom::INTEGRATOR_ARC // Step integrator: ARC, RK2 or EXPONENTIAL
+#define GYRO_BIAS_CORRECTION 0 // Remove IMU drift measured when still (1 or 0)
+#define TWIST_SOURCE                                                           \
+	arms::odom::TWIST_DIFFERENTIATOR // Velocity from: DIFFERENTIATOR or SENSOR
+
+// Pose filter, using the GPS requires resetting the odometry to the GPS field
+// coordinates in inches, with the origin at the center of the field
+#define POSE_FILTER 0     // Fuse the encoders, IMU and GPS in a Kalman filter
+#define GPS_PORT 0        // Port 0 for disabled
+#define GPS_OFFSET 0, 0   // GPS distance forward and left of tracking center
+
+// Distance sensor localization, also in field coordinates. Each sensor is
+// {port, inches forward, inches left, degrees counterclockwise from forward}
+#define DISTANCE_SENSORS // Empty for disabled
+#define MCL_PERIOD 50    // Localization period in milliseconds
 
 // Movement tuning
 #define SLEW_STEP 8             // Smaller number = more slew
@@ -49,6 +74,50 @@ namespace arms {
 #define MIN_LINEAR_SPEED 0  // Minimum speed for linear movements
 #define MIN_ANGULAR_SPEED 0 // Minimum speed for angular movements
 
+// Velocity control
+#define WHEEL_DIAMETER 0 // Drive wheel diameter in inches, 0 for percent units
+#define GEAR_RATIO 1     // Wheel rotations per motor rotation
+#define DRIVE_WIDTH 0    // Distance between the left and right drive wheels
+#define VELOCITY_MODE                                                          \
+	arms::chassis::VELOCITY_INTERNAL // Motor (INTERNAL) or ARMS velocity control
+#define VELOCITY_KP 0.5 // Feedback gain of the ARMS velocity controller
+
+// Feedforward, kS (volts), kV (volts per velocity) and kA (volts per
+// acceleration) with velocity in the units of chassis::getMaxVelocity()
+#define LEFT_FEEDFORWARD 0, 0, 0  // kS, kV, kA of the left side
+#define RIGHT_FEEDFORWARD 0, 0, 0 // kS, kV, kA of the right side
+
+// Battery compensation
+#define BATTERY_COMPENSATION 0 // Scale voltage output by the battery (1 or 0)
+#define NOMINAL_VOLTAGE 12     // Battery voltage the movements are tuned at
+
+// Motion profiling of 1D moves and turns, needs the wheel diameter
+#define PROFILE_TYPE                                                           \
+	arms::PROFILE_NONE // PROFILE_NONE, PROFILE_TRAPEZOID or PROFILE_S_CURVE
+#define PROFILE_ACCEL 60          // Linear acceleration limit (in/s^2)
+#define PROFILE_JERK 400          // Linear jerk limit (in/s^3)
+#define PROFILE_ANGULAR_ACCEL 720 // Turn acceleration limit (deg/s^2)
+#define PROFILE_ANGULAR_JERK 5000 // Turn jerk limit (deg/s^3)
+
+// Pure pursuit path following, velocities need the wheel diameter
+#define PURSUIT_MIN_LOOKAHEAD 8  // Lookahead distance at low speed (inches)
+#define PURSUIT_MAX_LOOKAHEAD 16 // Lookahead distance at full speed (inches)
+#define PURSUIT_SPACING 2        // Distance between path points (inches)
+#define PURSUIT_SMOOTHING 0.75   // Path smoothing from 0 to 1
+#define PURSUIT_TURN_RATE 3      // Turning speed limit around curves (rad/s)
+#define PURSUIT_ACCEL 60         // Acceleration limit (in/s^2)
+
+// RAMSETE trajectory tracking, trajectories are generated with the pure
+// pursuit path options
+#define RAMSETE_B 0.00129 // Correction gain, 2.0 for meters (rad^2/in^2)
+#define RAMSETE_ZETA 0.7  // Damping from 0 to 1
+
+// Control loop timing
+#define CHASSIS_PERIOD 10  // Period of the chassis task in milliseconds
+#define ODOM_PERIOD 10     // Period of the odometry task in milliseconds
+#define FUSED_CONTROL 0    // Update odometry from the chassis task (1 or 0)
+#define SENSOR_RATE_ODOM 0 // Poll rotation sensors every 5ms (1 or 0)
+
 // Auton selector configuration constants
 #define AUTONS "Front", "Back", "Do Nothing" // Names of autonomi, up to 10
 #define HUE 0     // Color of theme from 0-359(H part of HSV)
@@ -60,10 +129,27 @@ inline void init() {
 	chassis::init({LEFT_MOTORS}, {RIGHT_MOTORS}, GEARSET, SLEW_STEP,
 	              LINEAR_EXIT_ERROR, ANGULAR_EXIT_ERROR, SETTLE_THRESH_LINEAR,
 	              SETTLE_THRESH_ANGULAR, SETTLE_TIME, MIN_LINEAR_SPEED,
-	              MIN_ANGULAR_SPEED);
+	              MIN_ANGULAR_SPEED, CHASSIS_PERIOD, TIMING_DEBUG, WHEEL_DIAMETER,
+	              GEAR_RATIO, VELOCITY_MODE, VELOCITY_KP, {LEFT_FEEDFORWARD},
+	              {RIGHT_FEEDFORWARD}, BATTERY_COMPENSATION, NOMINAL_VOLTAGE,
+	              CHASSIS_TYPE, {STRAFE_MOTORS}, PROFILE_TYPE, PROFILE_ACCEL,
+	              PROFILE_JERK, PROFILE_ANGULAR_ACCEL, PROFILE_ANGULAR_JERK,
+	              DRIVE_WIDTH);
 
 	odom::init(ODOM_DEBUG, ENCODER_TYPE, {ENCODER_PORTS}, EXPANDER_PORT, IMU_PORT,
-	           TRACK_WIDTH, MIDDLE_DISTANCE, TPI, MIDDLE_TPI);
+	           TRACK_WIDTH, MIDDLE_DISTANCE, TPI, MIDDLE_TPI, ODOM_PERIOD,
+	           FUSED_CONTROL, SENSOR_RATE_ODOM, MOTOR_ENCODER_MODE,
+	           ODOM_INTEGRATOR, POSE_FILTER, GPS_PORT, {GPS_OFFSET},
+	           GYRO_BIAS_CORRECTION, {EXTRA_IMU_PORTS}, TWIST_SOURCE);
+
+	if (LOAD_CALIBRATION && !calibration::load())
+		printf("ARMS WARNING: no tracking wheel calibration on the SD card\n");
+
+	mcl::init({DISTANCE_SENSORS}, MCL_PERIOD);
+
+	pursuit::init(PURSUIT_MIN_LOOKAHEAD, PURSUIT_MAX_LOOKAHEAD, PURSUIT_SPACING,
+	              PURSUIT_SMOOTHING, PURSUIT_TURN_RATE, PURSUIT_ACCEL);
+	ramsete::init(RAMSETE_B, RAMSETE_ZETA);
 
 	pid::init(LINEAR_KP, LINEAR_KI, LINEAR_KD, ANGULAR_KP, ANGULAR_KI, ANGULAR_KD,
 	          TRACKING_KP, MIN_ERROR, LEAD_PCT);
@@ -0,0 +1,51 @@
+#ifndef _ARMS_EKF_H_
+#define _ARMS_EKF_H_
+
+#include "ARMS/point.h"
+#include <cstdint>
+
+namespace arms::odom {
+
+/**
+ * Extended Kalman filter over the robot pose (x, y, heading).
+ *
+ * The tracking wheel odometry is the motion model, absolute heading and
+ * position readings are corrections. All matrices are fixed size 3x3 arrays
+ * so an update never allocates.
+ */
+class Ekf {
+	public:
+	/**
+	 * Set the pose and forget the covariance
+	 */
+	void reset(double x, double y, double theta);
+
+	/**
+	 * Advance the pose by one odometry step. delta is the field displacement of
+	 * the step, forward, left and delta_angle are the robot frame motion used to
+	 * scale the process noise.
+	 */
+	void predict(Point delta, double forward, double left, double delta_angle);
+
+	/**
+	 * Correct with an absolute heading in radians. Returns false if the reading
+	 * was rejected as an outlier.
+	 */
+	bool correctHeading(double theta, double variance);
+
+	/**
+	 * Correct with an absolute position in inches. Returns false if the reading
+	 * was rejected as an outlier.
+	 */
+	bool correctPosition(double x, double y, double variance);
+
+	double x = 0;
+	double y = 0;
+	double theta = 0;
+	double P[3][3] = {{0}}; // covariance of x, y and theta
+	uint32_t rejected = 0;  // readings rejected by the outlier gate
+};
+
+} // namespace arms::odom
+
+#endif
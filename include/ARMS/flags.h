@@ -10,6 +10,7 @@ struct MoveFlags {
 	bool thru;
 	bool reverse;
 	bool relative;
+	bool velocity;
 
 	MoveFlags operator|(MoveFlags& o) {
 		MoveFlags ret;
@@ -18,6 +19,7 @@ struct MoveFlags {
 		ret.thru = thru || o.thru;
 		ret.reverse = reverse || o.reverse;
 		ret.relative = relative || o.relative;
+		ret.velocity = velocity || o.velocity;
 		return ret;
 	}
 
@@ -28,6 +30,7 @@ struct MoveFlags {
 		ret.thru = thru && o.thru;
 		ret.reverse = reverse && o.reverse;
 		ret.relative = relative && o.relative;
+		ret.velocity = velocity && o.velocity;
 		return ret;
 	}
 
@@ -38,6 +41,7 @@ struct MoveFlags {
 		ret.thru = !thru;
 		ret.reverse = !reverse;
 		ret.relative = !relative;
+		ret.velocity = !velocity;
 		return ret;
 	}
 
@@ -48,12 +52,13 @@ struct MoveFlags {
 		ret.thru = thru || o.thru;
 		ret.reverse = reverse || o.reverse;
 		ret.relative = relative || o.relative;
+		ret.velocity = velocity || o.velocity;
 		return ret;
 	}
 
 
 	operator bool() {
-		return async || true_relative || thru || reverse || relative;
+		return async || true_relative || thru || reverse || relative || velocity;
 	}
 };
 
@@ -64,6 +69,7 @@ inline MoveFlags operator|(const MoveFlags& f, MoveFlags& o) {
 	ret.thru = f.thru || o.thru;
 	ret.reverse = f.reverse || o.reverse;
 	ret.relative = f.relative || o.relative;
+	ret.velocity = f.velocity || o.velocity;
 	return ret;
 }
 
@@ -74,6 +80,7 @@ inline MoveFlags operator&(const MoveFlags& f, MoveFlags& o) {
 	ret.thru = f.thru && o.thru;
 	ret.reverse = f.reverse && o.reverse;
 	ret.relative = f.relative && o.relative;
+	ret.velocity = f.velocity && o.velocity;
 	return ret;
 }
 
@@ -84,6 +91,7 @@ inline MoveFlags operator|(const MoveFlags& f, const MoveFlags& o) {
 	ret.thru = f.thru || o.thru;
 	ret.reverse = f.reverse || o.reverse;
 	ret.relative = f.relative || o.relative;
+	ret.velocity = f.velocity || o.velocity;
 	return ret;
 }
 
@@ -94,21 +102,24 @@ inline MoveFlags operator&(const MoveFlags& f, const MoveFlags& o) {
 	ret.thru = f.thru && o.thru;
 	ret.reverse = f.reverse && o.reverse;
 	ret.relative = f.relative && o.relative;
+	ret.velocity = f.velocity && o.velocity;
 	return ret;
 }
 
-const MoveFlags NONE = {false, false, false, false, false};
-const MoveFlags ASYNC = {true, false, false, false, false};
-const MoveFlags TRUE_RELATIVE = {false, true, false, false, false};
-const MoveFlags THRU = {false, false, true, false, false};
-const MoveFlags REVERSE = {false, false, false, true, false};
-const MoveFlags RELATIVE = {false, false, false, false, true};
-
-const MoveFlags NOT_ASYNC = {false, true, true, true, true};
-const MoveFlags NOT_TRUE_RELATIVE = {true, false, true, true, true};
-const MoveFlags NOT_THRU = {true, true, false, true, true};
-const MoveFlags NOT_REVERSE = {true, true, true, false, true};
-const MoveFlags NOT_RELATIVE = {true, true, true, true, false};
+const MoveFlags NONE = {false, false, false, false, false, false};
+const MoveFlags ASYNC = {true, false, false, false, false, false};
+const MoveFlags TRUE_RELATIVE = {false, true, false, false, false, false};
+const MoveFlags THRU = {false, false, true, false, false, false};
+const MoveFlags REVERSE = {false, false, false, true, false, false};
+const MoveFlags RELATIVE = {false, false, false, false, true, false};
+const MoveFlags VELOCITY = {false, false, false, false, false, true};
+
+const MoveFlags NOT_ASYNC = {false, true, true, true, true, true};
+const MoveFlags NOT_TRUE_RELATIVE = {true, false, true, true, true, true};
+const MoveFlags NOT_THRU = {true, true, false, true, true, true};
+const MoveFlags NOT_REVERSE = {true, true, true, false, true, true};
+const MoveFlags NOT_RELATIVE = {true, true, true, true, false, true};
+const MoveFlags NOT_VELOCITY = {true, true, true, true, true, false};
 
 
 } // namespace arms
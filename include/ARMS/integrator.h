@@ -0,0 +1,72 @@
+#ifndef _ARMS_INTEGRATOR_H_
+#define _ARMS_INTEGRATOR_H_
+
+#include "ARMS/point.h"
+#include <cmath>
+
+namespace arms::odom {
+
+// Method used to integrate each odometry step
+typedef enum Integrator {
+	INTEGRATOR_ARC,        // chord of the arc, the original ARMS method
+	INTEGRATOR_RK2,        // straight line at the midpoint heading
+	INTEGRATOR_EXPONENTIAL // SE(2) pose exponential
+} Integrator_e_t;
+
+/**
+ * Return the field displacement of one odometry step.
+ *
+ * forward and left are the distances travelled by the tracking center in the
+ * robot frame, delta_angle is the change in heading in radians and heading is
+ * the heading at the start of the step.
+ *
+ * This has no dependencies on PROS so recorded encoder traces can be replayed
+ * through each integrator off the robot, see bench/integrator.cpp.
+ */
+inline Point integrate(Integrator_e_t integrator, double forward, double left,
+                       double delta_angle, double heading) {
+	double local_x = forward;
+	double local_y = left;
+	double p = heading; // angle the local displacement is rotated by
+
+	switch (integrator) {
+	case INTEGRATOR_RK2:
+		// the step is a straight line along the average heading
+		p = heading + delta_angle / 2.0;
+		break;
+	case INTEGRATOR_EXPONENTIAL: {
+		// sin(x) / x and (1 - cos(x)) / x, with series expansions near zero where
+		// the closed forms lose precision
+		double a2 = delta_angle * delta_angle;
+		double s;
+		double c;
+		if (fabs(delta_angle) < 1e-2) {
+			s = 1 - a2 / 6 * (1 - a2 / 20);
+			c = delta_angle / 2 * (1 - a2 / 12);
+		} else {
+			s = sin(delta_angle) / delta_angle;
+			c = (1 - cos(delta_angle)) / delta_angle;
+		}
+		local_x = s * forward - c * left;
+		local_y = c * forward + s * left;
+		break;
+	}
+	default:
+		// the chord of the arc along the average heading
+		if (delta_angle) {
+			double i = sin(delta_angle / 2.0) * 2.0;
+			local_x = forward / delta_angle * i;
+			local_y = left / delta_angle * i;
+		}
+		p = heading + delta_angle / 2.0;
+		break;
+	}
+
+	// convert to absolute displacement
+	return {cos(p) * local_x - sin(p) * local_y,
+	        cos(p) * local_y + sin(p) * local_x};
+}
+
+} // namespace arms::odom
+
+#endif
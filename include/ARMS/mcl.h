@@ -0,0 +1,64 @@
+#ifndef _ARMS_MCL_H_
+#define _ARMS_MCL_H_
+
+#include "ARMS/odom.h"
+#include "ARMS/point.h"
+#include "ARMS/scheduler.h"
+#include <initializer_list>
+
+namespace arms::mcl {
+
+// Distance sensor mounted on the robot
+typedef struct sensor_s {
+	int port;
+	double forward; // inches forward of the tracking center
+	double left;    // inches left of the tracking center
+	double angle;   // degrees counterclockwise from straight ahead
+} sensor_s_t;
+
+/**
+ * Add a static field element to the map as a line segment between two points,
+ * in field coordinates. The field walls are added by init().
+ */
+void addSegment(Point a, Point b);
+
+/**
+ * Remove every segment from the map, including the field walls
+ */
+void clearMap();
+
+/**
+ * Spread the particles around the current odometry pose again
+ */
+void reset();
+
+/**
+ * Return the weighted mean pose of the particles
+ */
+odom::Pose getEstimate();
+
+/**
+ * Return the standard deviation of the particle positions in inches
+ */
+double getSpread();
+
+/**
+ * Return the measured timing of the localization task
+ */
+loop_stats_s_t getLoopStats();
+
+/**
+ * Start Monte Carlo localization with distance sensors against a map of the
+ * field. The particles are moved by the odometry and weighted by how well
+ * the distance readings match rays cast through the map. Once the particles
+ * agree on a position it is used to correct the odometry.
+ *
+ * The map is in the GPS field frame, inches from the center of the field, so
+ * the odometry must be reset to field coordinates. Nothing is started if
+ * there are no sensors.
+ */
+void init(std::initializer_list<sensor_s_t> sensors, int period = 50);
+
+} // namespace arms::mcl
+
+#endif
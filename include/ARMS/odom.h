@@ -1,13 +1,25 @@
 #ifndef _ARMS_ODOM_H_
 #define _ARMS_ODOM_H_
 
+#include "ARMS/ekf.h"
+#include "ARMS/integrator.h"
 #include "ARMS/point.h"
+#include "ARMS/scheduler.h"
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
 
 namespace arms::odom {
 
 typedef enum EncoderType { ENCODER_ADI, ENCODER_ROTATION } EncoderType_e_t;
 
+// How the motor encoders are combined when there are no tracking wheels
+typedef enum MotorEncoderMode {
+	MOTOR_ENCODER_FIRST,
+	MOTOR_ENCODER_MEAN,
+	MOTOR_ENCODER_MEDIAN
+} MotorEncoderMode_e_t;
+
 // Odom Configuration
 typedef struct config_data_s {
 	int expanderPort = 0;
@@ -18,9 +30,50 @@ typedef struct config_data_s {
     EncoderType_e_t encoderType;
 } config_data_s_t;
 
-// sensors
+// Snapshot of the robot pose
+struct Pose {
+	double x;
+	double y;
+	double theta;  // heading in radians
+	uint32_t time; // pros::millis() when the pose was computed
+};
+
+// Velocity or acceleration of the robot. In the field frame x and y are along
+// the field axes, in the robot frame x is forward and y is left. theta is the
+// counterclockwise angular rate in radians.
+struct Twist {
+	double x;
+	double y;
+	double theta;
+};
+
+// Tracking wheel constants
+typedef struct tracking_s {
+	double tpi;             // encoder ticks per inch of forward movement
+	double middle_tpi;      // middle wheel ticks per inch
+	double track_width;     // distance between the left and right wheels
+	double middle_distance; // distance from the middle wheel to the center
+} tracking_s_t;
+
+// Where the velocity estimate comes from
+typedef enum TwistSource {
+	TWIST_DIFFERENTIATOR, // tracking filter on the integrated motion
+	TWIST_SENSOR          // rotation sensor velocities
+} TwistSource_e_t;
+
+extern config_data_s_t configData;
+
+// sensors, the first imu when several are fused
 extern std::shared_ptr<pros::Imu> imu;
 
+// odometry is updated by the chassis task instead of its own task
+extern bool fused;
+
+/**
+ * Run a single odometry update from the current sensor values
+ */
+void update();
+
 /**
  * Return the left encoder position
  */
@@ -36,6 +89,47 @@ double getRightEncoder();
  */
 double getMiddleEncoder();
 
+/**
+ * Return a consistent snapshot of the robot position and heading, this never
+ * blocks the odometry
+ */
+Pose getPose();
+
+/**
+ * Return the robot pose at a past pros::millis() time, interpolated from the
+ * pose history. Times outside the history return the closest recorded pose.
+ */
+Pose getPositionAt(uint32_t time);
+
+/**
+ * Correct the position with an absolute reading in inches taken at a past
+ * pros::millis() time. With the pose filter the reading is fused with the
+ * given variance, otherwise the position is moved part of the way towards it.
+ * Returns the change made to the pose.
+ */
+Pose correct(Point point, uint32_t time, double variance);
+
+/**
+ * Return the tracking wheel constants in use
+ */
+tracking_s_t getTracking();
+
+/**
+ * Replace the tracking wheel constants, for example with calibrated values
+ */
+void setTracking(tracking_s_t tracking);
+
+/**
+ * Return the filtered robot velocity in inches and radians per second
+ */
+Twist getVelocity(bool field = false);
+
+/**
+ * Return the filtered robot acceleration in inches and radians per second
+ * squared
+ */
+Twist getAcceleration(bool field = false);
+
 /**
  * Return the robot position coordinates
  */
@@ -87,12 +181,63 @@ double getAngleError(Point point);
  */
 double getDistanceError(Point point);
 
+/**
+ * Return the measured timing of the odometry task
+ */
+loop_stats_s_t getLoopStats();
+
+/**
+ * Clear the odometry task timing
+ */
+void resetLoopStats();
+
+/**
+ * Return the standard deviation of the pose filter estimate, x and y in inches
+ * and heading in degrees
+ */
+std::array<double, 3> getUncertainty();
+
+/**
+ * Return the estimated gyro bias of an imu in degrees per second
+ */
+double getGyroBias(int sensor = 0);
+
+/**
+ * Return the estimated scale of an imu relative to the fused heading
+ */
+double getImuScale(int sensor = 0);
+
+/**
+ * Return whether an imu was dropped for disagreeing with the others
+ */
+bool isImuFaulted(int sensor = 0);
+
+/**
+ * Return the number of imu and gps readings the pose filter rejected as
+ * outliers
+ */
+uint32_t getRejectedReadings();
+
+/**
+ * Return the measured rate in Hz at which the odometry integrates a step. With
+ * sensor rate odometry this is the rate new sensor samples arrive, not the
+ * rate they are polled at.
+ */
+double getUpdateRate();
+
 /**
  * Initialize the odometry
  */
 void init(bool debug, EncoderType_e_t encoderType, std::array<int, 3> encoderPorts,
           int expanderPort, int imuPort, double track_width,
-          double middle_distance, double tpi, double middle_tpi);
+          double middle_distance, double tpi, double middle_tpi,
+          int period = 10, bool fused = false, bool sensor_rate = false,
+          MotorEncoderMode_e_t motorEncoderMode = MOTOR_ENCODER_FIRST,
+          Integrator_e_t integrator = INTEGRATOR_ARC, bool filter = false,
+          int gpsPort = 0, std::array<double, 2> gpsOffset = {0, 0},
+          bool bias_correction = false,
+          std::initializer_list<int> extraImuPorts = {},
+          TwistSource_e_t twistSource = TWIST_DIFFERENTIATOR);
 
 } // namespace arms::odom
 
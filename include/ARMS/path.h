@@ -0,0 +1,79 @@
+#ifndef _ARMS_PATH_H_
+#define _ARMS_PATH_H_
+
+#include "ARMS/point.h"
+#include <vector>
+
+namespace arms {
+
+// Spline joining the waypoints of a path
+typedef enum SplineType {
+	SPLINE_CUBIC_HERMITE,  // continuous heading
+	SPLINE_QUINTIC_HERMITE // continuous heading and curvature
+} SplineType_e_t;
+
+// Pose a hermite spline passes through
+typedef struct waypoint_s {
+	double x;
+	double y;
+	double theta; // degrees counterclockwise
+} waypoint_s_t;
+
+// Entry of a path lookup table
+typedef struct path_sample_s {
+	double distance;  // inches along the path from the start
+	double x;         // inches
+	double y;         // inches
+	double theta;     // radians counterclockwise, continuous along the path
+	double curvature; // 1/inches, positive to the left
+} path_sample_s_t;
+
+/**
+ * Spline path precomputed into a lookup table evenly spaced in arc length, so
+ * the pose at any distance along it is found in constant time.
+ */
+class Path {
+	public:
+	Path();
+
+	/**
+	 * Join a list of poses with hermite splines. The tangent at each pose
+	 * points along its heading and is scaled by the distance to the neighbouring
+	 * pose, a quintic spline also starts and ends each segment with zero
+	 * curvature.
+	 */
+	Path(SplineType_e_t type, std::vector<waypoint_s_t> waypoints,
+	     double spacing = 1);
+
+	/**
+	 * Join cubic bezier curves through a list of control points. The curves
+	 * share their end points, so there must be 3n + 1 points: the start, then
+	 * two handles and an end for each curve.
+	 */
+	Path(std::vector<Point> control, double spacing = 1);
+
+	/**
+	 * Return the pose and curvature at a distance along the path, interpolated
+	 * between the table entries and clamped to the ends
+	 */
+	path_sample_s_t sample(double distance) const;
+
+	/**
+	 * Return the length of the path in inches
+	 */
+	double getLength() const;
+
+	/**
+	 * Return the lookup table, evenly spaced in distance
+	 */
+	const path_sample_s_t* data() const;
+	int size() const;
+
+	private:
+	std::vector<path_sample_s_t> table;
+	double spacing;
+};
+
+} // namespace arms
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef _ARMS_PID_H_
 #define _ARMS_PID_H_
 
+#include "ARMS/profile.h"
 #include <array>
 
 namespace arms::pid {
@@ -10,6 +11,9 @@ extern int mode;
 #define DISABLE 0
 #define TRANSLATIONAL 1
 #define ANGULAR 2
+#define MANUAL 3 // the motors are driven directly, the chassis task stays off
+#define FOLLOW 4     // pure pursuit along a path
+#define TRAJECTORY 5 // ramsete tracking of a trajectory
 
 // pid constants
 extern double linearKP;
@@ -35,9 +39,15 @@ extern bool reverse;
 
 extern bool canReverse;
 
+// motion profile of the current 1D move or turn
+extern bool profiled;
+void startProfile(Profile profile, double heading);
+bool profileDone();
+
 // pid functions
 std::array<double, 2> translational();
 std::array<double, 2> angular();
+std::array<double, 3> holonomic(); // forward, left, counterclockwise
 
 // initializer
 void init(double linearKP, double linearKI, double linearKD, double angularKP,
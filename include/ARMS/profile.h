@@ -0,0 +1,59 @@
+#ifndef _ARMS_PROFILE_H_
+#define _ARMS_PROFILE_H_
+
+namespace arms {
+
+// Shape of a motion profile
+typedef enum ProfileType {
+	PROFILE_NONE,      // step straight to the target
+	PROFILE_TRAPEZOID, // acceleration limited
+	PROFILE_S_CURVE    // acceleration and jerk limited
+} ProfileType_e_t;
+
+// Setpoint of a motion profile at a point in time
+typedef struct profile_point_s {
+	double position;
+	double velocity;
+	double acceleration;
+} profile_point_s_t;
+
+/**
+ * Time parameterised one dimensional motion profile from rest to rest.
+ *
+ * The profile is made of seven constant jerk segments: jerk up, constant
+ * acceleration, jerk down, cruise and the mirror image to stop. A trapezoid
+ * is the same with zero length jerk segments. Segments are shortened or
+ * dropped when the distance is too short to reach the limits.
+ */
+class Profile {
+	public:
+	Profile();
+
+	/**
+	 * Plan a profile over a signed distance. The limits are magnitudes in
+	 * consistent units, max_jerk is only used by an S-curve.
+	 */
+	Profile(ProfileType_e_t type, double distance, double max_velocity,
+	        double max_acceleration, double max_jerk = 0);
+
+	/**
+	 * Return the setpoint t seconds after the start of the profile
+	 */
+	profile_point_s_t sample(double t);
+
+	/**
+	 * Return the length of the profile in seconds
+	 */
+	double getDuration();
+
+	private:
+	double direction;
+	double times[8]; // start time of each segment, and the end
+	double jerk[7];
+	profile_point_s_t starts[7]; // setpoint at the start of each segment
+	profile_point_s_t end;
+};
+
+} // namespace arms
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _ARMS_PURSUIT_H_
+#define _ARMS_PURSUIT_H_
+
+#include "ARMS/path.h"
+#include "ARMS/point.h"
+#include <vector>
+
+namespace arms::pursuit {
+
+// Point of a generated path
+typedef struct path_point_s {
+	double x;
+	double y;
+	double distance;  // inches along the path from the start
+	double curvature; // 1/inches, positive to the left
+	double velocity;  // target in the units of chassis::getMaxVelocity()
+} path_point_s_t;
+
+/**
+ * Generate a path through the waypoints. Points are injected at an even
+ * spacing and the path is smoothed, then each point gets a target velocity
+ * limited by the curvature and by the acceleration from rest at the start
+ * and to a stop at the end. max_velocity is in the units of
+ * chassis::getMaxVelocity().
+ *
+ * Returns the number of points written to out, or -1 if the path is empty or
+ * does not fit.
+ */
+int generate(std::vector<Point> waypoints, double max_velocity,
+             path_point_s_t* out, int capacity);
+
+/**
+ * Plan the target velocities along a spline path, which is used as it is
+ * without injecting or smoothing points
+ */
+int generate(const Path& path, double max_velocity, path_point_s_t* out,
+             int capacity);
+
+/**
+ * Generate a path from the robot through the waypoints and start following
+ * it, returns false if the path is empty or too long to store
+ */
+bool start(std::vector<Point> waypoints, double max_velocity,
+           bool reverse = false);
+
+/**
+ * Start following a spline path in field coordinates, returns false if it is
+ * empty or too long to store
+ */
+bool start(const Path& path, double max_velocity, bool reverse = false);
+
+/**
+ * Follow the current path with adaptive lookahead pure pursuit, the wheel
+ * velocities are set as the chassis reference
+ */
+void update();
+
+/**
+ * Return true once the robot has reached the end of the path
+ */
+bool done(double exit_error);
+
+/**
+ * Return the number of points in the current path
+ */
+int getPathSize();
+
+/**
+ * Return a point of the current path
+ */
+path_point_s_t getPathPoint(int index);
+
+/**
+ * Return the point on the path the robot is steering towards
+ */
+Point getLookahead();
+
+/**
+ * Set the tuning of the path generation and follower. The lookahead grows
+ * from min_lookahead to max_lookahead with the target velocity, turn_rate
+ * limits the velocity around curves in radians per second, and acceleration
+ * is in the units of chassis::getMaxVelocity() per second.
+ */
+void init(double min_lookahead, double max_lookahead, double spacing,
+          double smoothing, double turn_rate, double acceleration);
+
+} // namespace arms::pursuit
+
+#endif
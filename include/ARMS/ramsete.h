@@ -0,0 +1,86 @@
+#ifndef _ARMS_RAMSETE_H_
+#define _ARMS_RAMSETE_H_
+
+#include "ARMS/path.h"
+#include "ARMS/point.h"
+#include <vector>
+
+namespace arms::ramsete {
+
+// State of a trajectory at a point in time
+typedef struct trajectory_point_s {
+	double time;             // seconds from the start
+	double x;                // inches
+	double y;                // inches
+	double theta;            // radians counterclockwise
+	double velocity;         // units of chassis::getMaxVelocity(), negative in
+	                         // reverse
+	double angular_velocity; // radians per second counterclockwise
+	double acceleration;     // units of chassis::getMaxVelocity() per second
+} trajectory_point_s_t;
+
+/**
+ * Time parameterise a path through the waypoints, generated as in
+ * pursuit::generate(), driving backwards if reverse is set. Returns the
+ * number of points written to out, or -1 if the path is empty or does not
+ * fit.
+ */
+int generate(std::vector<Point> waypoints, double max_velocity, bool reverse,
+             trajectory_point_s_t* out, int capacity);
+
+/**
+ * Time parameterise a spline path, taking the heading from its lookup table
+ */
+int generate(const Path& path, double max_velocity, bool reverse,
+             trajectory_point_s_t* out, int capacity);
+
+/**
+ * Start tracking a trajectory in field coordinates. The points are read in
+ * place, they must stay valid until the trajectory is finished.
+ */
+void start(const trajectory_point_s_t* trajectory, int size);
+
+/**
+ * Generate a trajectory from the robot through the waypoints and start
+ * tracking it, returns false if the path is empty or too long to store
+ */
+bool start(std::vector<Point> waypoints, double max_velocity,
+           bool reverse = false);
+
+/**
+ * Generate a trajectory along a spline path in field coordinates and start
+ * tracking it, returns false if the path is empty or too long to store
+ */
+bool start(const Path& path, double max_velocity, bool reverse = false);
+
+/**
+ * Track the current trajectory, the wheel velocities are set as the chassis
+ * reference
+ */
+void update();
+
+/**
+ * Return true while the trajectory still has time left to run
+ */
+bool isRunning();
+
+/**
+ * Return true once the trajectory has run out of time and the robot is
+ * within exit_error inches of its end
+ */
+bool done(double exit_error);
+
+/**
+ * Return the state of the trajectory the robot is currently tracking
+ */
+trajectory_point_s_t getTarget();
+
+/**
+ * Set the gains of the controller, b in rad^2/in^2 acts like a proportional
+ * term (larger values correct harder) and zeta between 0 and 1 like damping
+ */
+void init(double b, double zeta);
+
+} // namespace arms::ramsete
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef _ARMS_SCHEDULER_H_
+#define _ARMS_SCHEDULER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace arms {
+
+// number of 1ms wide bins in the loop period histogram, the last bin also
+// counts every longer period
+#define LOOP_HISTOGRAM_BINS 32
+
+// Execution time statistics of a section of code, times are in milliseconds
+typedef struct time_stats_s {
+	double average = 0; // filtered execution time
+	double max = 0;     // longest execution time
+	uint32_t count = 0;
+} time_stats_s_t;
+
+// Loop timing statistics, all times are in milliseconds
+typedef struct loop_stats_s {
+	double period = 0;     // filtered measured period
+	double jitter = 0;     // filtered deviation from the nominal period
+	double max_period = 0; // longest measured period
+	uint32_t overruns = 0; // iterations that missed their deadline
+	uint32_t iterations = 0;
+	time_stats_s_t compute; // time from waking up to waiting again
+	uint32_t histogram[LOOP_HISTOGRAM_BINS] = {0}; // measured periods
+} loop_stats_s_t;
+
+/**
+ * Add an execution time in milliseconds to a set of statistics
+ */
+void addTime(time_stats_s_t& stats, double time);
+
+/**
+ * Print loop statistics to the terminal
+ */
+void printStats(const char* name, loop_stats_s_t stats);
+
+/**
+ * Print execution time statistics to the terminal
+ */
+void printStats(const char* name, time_stats_s_t stats);
+
+/**
+ * Fixed rate loop scheduler built on pros::Task::delay_until. Unlike
+ * pros::delay, the time spent computing an iteration does not add to the
+ * period of the loop.
+ *
+ * If an iteration runs past its deadline the overrun is counted and the
+ * schedule is realigned to the current time instead of running a burst of
+ * catch up iterations.
+ */
+class Scheduler {
+	public:
+	Scheduler(uint32_t period = 10);
+
+	/**
+	 * Set the nominal loop period in milliseconds
+	 */
+	void setPeriod(uint32_t period);
+
+	/**
+	 * Return the nominal loop period in milliseconds
+	 */
+	uint32_t getPeriod();
+
+	/**
+	 * Block until the start of the next period
+	 */
+	void wait();
+
+	/**
+	 * Return the measured timing of the loop, safe to call from any task
+	 */
+	loop_stats_s_t getStats();
+
+	/**
+	 * Clear the measured timing of the loop, the loop clears it when it next
+	 * wakes up
+	 */
+	void resetStats();
+
+	private:
+	uint32_t period;
+	uint32_t prev_wake;
+	uint64_t prev_tick;
+	bool started;
+	std::atomic<bool> reset;
+
+	// only touched by the loop, copied out to published after each iteration
+	loop_stats_s_t stats;
+
+	// an odd sequence number marks published as being written
+	std::atomic<uint32_t> seq;
+	loop_stats_s_t published;
+
+	void publish();
+};
+
+} // namespace arms
+
+#endif
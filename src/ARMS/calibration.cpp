@@ -0,0 +1,182 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms::calibration {
+
+#define CALIBRATION_FILE "/usd/arms_odometry.txt"
+
+// longest time in milliseconds allowed for each turn of a spin
+#define SPIN_TIMEOUT 20000
+
+typedef struct encoders_s {
+	double left;
+	double right;
+	double middle;
+} encoders_s_t;
+
+encoders_s_t read() {
+	return {odom::getLeftEncoder(), odom::getRightEncoder(),
+	        odom::configData.middleEncoderPort ? odom::getMiddleEncoder() : 0};
+}
+
+void waitForA(pros::Controller& master) {
+	while (!master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_A))
+		pros::delay(20);
+}
+
+// encoder change over a push by hand between two presses of A
+encoders_s_t push(pros::Controller& master, const char* direction,
+                  double distance) {
+	printf("ARMS calibration: press A, push the robot %s %.1f inches, then press "
+	       "A again\n",
+	       direction, distance);
+	waitForA(master);
+	encoders_s_t start = read();
+	master.rumble(".");
+	waitForA(master);
+	encoders_s_t end = read();
+	master.rumble(".");
+	return {end.left - start.left, end.right - start.right,
+	        end.middle - start.middle};
+}
+
+// spin in place and measure the encoder change, and the counterclockwise
+// rotation measured by the imu in radians. Returns false if the imu could not
+// be read.
+bool spin(double voltage, int turns, encoders_s_t* change, double* rotation) {
+	double start_rotation = odom::imu->get_rotation();
+	if (start_rotation == PROS_ERR_F)
+		return false;
+	encoders_s_t start = read();
+	uint32_t start_time = pros::millis();
+
+	chassis::leftMotors->move_voltage(-voltage * 1000);
+	chassis::rightMotors->move_voltage(voltage * 1000);
+	double current = start_rotation;
+	while (current != PROS_ERR_F &&
+	       fabs(current - start_rotation) < turns * 360.0 &&
+	       pros::millis() - start_time < (uint32_t)(SPIN_TIMEOUT * turns)) {
+		pros::delay(10);
+		current = odom::imu->get_rotation();
+	}
+	chassis::leftMotors->move_voltage(0);
+	chassis::rightMotors->move_voltage(0);
+	if (current == PROS_ERR_F)
+		return false;
+	pros::delay(1500); // measure the coast to a stop too
+
+	double end_rotation = odom::imu->get_rotation();
+	if (end_rotation == PROS_ERR_F)
+		return false;
+	encoders_s_t end = read();
+	*rotation = -(end_rotation - start_rotation) * M_PI / 180;
+	*change = {end.left - start.left, end.right - start.right,
+	           end.middle - start.middle};
+	return true;
+}
+
+void save(odom::tracking_s_t tracking) {
+	if (!pros::usd::is_installed()) {
+		printf("ARMS WARNING: no SD card, calibration results not saved\n");
+		return;
+	}
+
+	FILE* file = fopen(CALIBRATION_FILE, "w");
+	if (file) {
+		fprintf(file, "#define TPI %f\n", tracking.tpi);
+		fprintf(file, "#define MIDDLE_TPI %f\n", tracking.middle_tpi);
+		fprintf(file, "#define TRACK_WIDTH %f\n", tracking.track_width);
+		fprintf(file, "#define MIDDLE_DISTANCE %f\n", tracking.middle_distance);
+		fclose(file);
+	}
+}
+
+bool load() {
+	if (!pros::usd::is_installed())
+		return false;
+	FILE* file = fopen(CALIBRATION_FILE, "r");
+	if (!file)
+		return false;
+
+	odom::tracking_s_t tracking = odom::getTracking();
+	char name[32];
+	double value;
+	int count = 0;
+	while (fscanf(file, "#define %31s %lf\n", name, &value) == 2) {
+		if (!strcmp(name, "TPI"))
+			tracking.tpi = value;
+		else if (!strcmp(name, "MIDDLE_TPI"))
+			tracking.middle_tpi = value;
+		else if (!strcmp(name, "TRACK_WIDTH"))
+			tracking.track_width = value;
+		else if (!strcmp(name, "MIDDLE_DISTANCE"))
+			tracking.middle_distance = value;
+		else
+			continue;
+		count++;
+	}
+	fclose(file);
+
+	if (count == 0 || tracking.tpi == 0 || tracking.track_width == 0)
+		return false;
+	odom::setTracking(tracking);
+	return true;
+}
+
+void run(double distance, int turns, double voltage) {
+	pros::Controller master(pros::E_CONTROLLER_MASTER);
+	odom::tracking_s_t tracking = odom::getTracking();
+	bool middle = odom::configData.middleEncoderPort != 0;
+
+	pid::mode = MANUAL; // keep the chassis task off the motors
+
+	// ticks per inch from known distance pushes
+	encoders_s_t forward = push(master, "straight forward", distance);
+	tracking.tpi = (fabs(forward.left) + fabs(forward.right)) / 2 / distance;
+	if (middle) {
+		encoders_s_t left = push(master, "straight left", distance);
+		tracking.middle_tpi = fabs(left.middle) / distance;
+	}
+
+	// in a spin in place each wheel travels its distance from the center times
+	// the rotation, both ways to cancel out any drift
+	if (odom::imu) {
+		printf("ARMS calibration: press A and the robot will spin in place\n");
+		waitForA(master);
+
+		encoders_s_t ccw;
+		encoders_s_t cw;
+		double ccw_rotation;
+		double cw_rotation;
+		if (!spin(voltage, turns, &ccw, &ccw_rotation) ||
+		    !spin(-voltage, turns, &cw, &cw_rotation)) {
+			printf("ARMS ERROR: lost the IMU while spinning, calibration "
+			       "aborted\n");
+			pid::mode = DISABLE;
+			return;
+		}
+		double rotation = ccw_rotation - cw_rotation;
+
+		double left = (ccw.left - cw.left) / tracking.tpi;
+		double right = (ccw.right - cw.right) / tracking.tpi;
+		tracking.track_width = (right - left) / rotation;
+		if (middle)
+			tracking.middle_distance =
+			    -(ccw.middle - cw.middle) / tracking.middle_tpi / rotation;
+	} else {
+		printf("ARMS WARNING: TRACK_WIDTH and MIDDLE_DISTANCE need an IMU to "
+		       "calibrate\n");
+	}
+
+	pid::mode = DISABLE;
+
+	printf("ARMS calibration: TPI %f, MIDDLE_TPI %f, TRACK_WIDTH %f, "
+	       "MIDDLE_DISTANCE %f\n",
+	       tracking.tpi, tracking.middle_tpi, tracking.track_width,
+	       tracking.middle_distance);
+
+	odom::setTracking(tracking);
+	save(tracking);
+}
+
+} // namespace arms::calibration
@@ -0,0 +1,218 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms::characterization {
+
+// most samples logged per side over all tests
+#define MAX_SAMPLES 4000
+
+// samples slower than this fraction of full speed are treated as stationary
+#define MIN_VELOCITY 0.02
+
+// smoothing of the differentiated acceleration
+#define ACCEL_FILTER 0.3
+
+// logging period in milliseconds
+#define SAMPLE_PERIOD 10
+
+typedef struct sample_s {
+	double voltage;
+	double velocity;
+	double acceleration;
+} sample_s_t;
+
+sample_s_t samples[2][MAX_SAMPLES];
+int sample_count = 0;
+
+fit_s_t fits[2];
+
+double sign(double x) {
+	return x > 0 ? 1 : (x < 0 ? -1 : 0);
+}
+
+void stop() {
+	chassis::leftMotors->move_voltage(0);
+	chassis::rightMotors->move_voltage(0);
+	pros::delay(1500); // let the robot come to rest
+}
+
+// drive both sides with voltage start + rate * t until the time, voltage or
+// distance limit is reached, logging a sample each tick
+void test(double start, double rate, double direction, uint32_t duration,
+          double max_distance) {
+	Scheduler scheduler(SAMPLE_PERIOD);
+	Point origin = odom::getPosition();
+	std::array<double, 2> prev_velocity = chassis::getWheelVelocity();
+	std::array<double, 2> acceleration = {0, 0};
+	uint32_t start_time = pros::millis();
+	uint64_t prev_tick = pros::micros();
+
+	while (true) {
+		double t = (pros::millis() - start_time) / 1000.0;
+		double voltage = start + rate * t;
+		if (t * 1000 > duration || voltage > 12 ||
+		    odom::getDistanceError(origin) > max_distance)
+			break;
+
+		chassis::leftMotors->move_voltage(direction * voltage * 1000);
+		chassis::rightMotors->move_voltage(direction * voltage * 1000);
+
+		scheduler.wait();
+
+		uint64_t tick = pros::micros();
+		double dt = (tick - prev_tick) / 1e6;
+		prev_tick = tick;
+
+		std::array<double, 2> velocity = chassis::getWheelVelocity();
+		for (int side = 0; side < 2; side++) {
+			double a = (velocity[side] - prev_velocity[side]) / dt;
+			acceleration[side] += (a - acceleration[side]) * ACCEL_FILTER;
+			if (sample_count < MAX_SAMPLES)
+				samples[side][sample_count] = {direction * voltage, velocity[side],
+				                               acceleration[side]};
+		}
+		prev_velocity = velocity;
+		if (sample_count < MAX_SAMPLES)
+			sample_count++;
+	}
+
+	stop();
+}
+
+// solve a 3x3 linear system with gaussian elimination
+bool solve(double a[3][3], double b[3], double x[3]) {
+	for (int col = 0; col < 3; col++) {
+		int pivot = col;
+		for (int row = col + 1; row < 3; row++)
+			if (fabs(a[row][col]) > fabs(a[pivot][col]))
+				pivot = row;
+		if (fabs(a[pivot][col]) < 1e-12)
+			return false;
+
+		for (int i = 0; i < 3; i++)
+			std::swap(a[col][i], a[pivot][i]);
+		std::swap(b[col], b[pivot]);
+
+		for (int row = col + 1; row < 3; row++) {
+			double f = a[row][col] / a[col][col];
+			for (int i = col; i < 3; i++)
+				a[row][i] -= f * a[col][i];
+			b[row] -= f * b[col];
+		}
+	}
+
+	for (int row = 2; row >= 0; row--) {
+		double sum = b[row];
+		for (int i = row + 1; i < 3; i++)
+			sum -= a[row][i] * x[i];
+		x[row] = sum / a[row][row];
+	}
+	return true;
+}
+
+// least squares fit of voltage = kS * sgn(v) + kV * v + kA * a
+fit_s_t fit(int side) {
+	double a[3][3] = {{0}};
+	double b[3] = {0};
+	double mean = 0;
+	double min_velocity = MIN_VELOCITY * chassis::getMaxVelocity();
+	fit_s_t result;
+
+	for (int i = 0; i < sample_count; i++) {
+		sample_s_t& s = samples[side][i];
+		if (fabs(s.velocity) < min_velocity)
+			continue;
+
+		double x[3] = {sign(s.velocity), s.velocity, s.acceleration};
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++)
+				a[row][col] += x[row] * x[col];
+			b[row] += x[row] * s.voltage;
+		}
+		mean += s.voltage;
+		result.samples++;
+	}
+
+	double k[3];
+	if (result.samples < 3 || !solve(a, b, k))
+		return result;
+	result.kS = k[0];
+	result.kV = k[1];
+	result.kA = k[2];
+
+	// goodness of fit
+	mean /= result.samples;
+	double ss_res = 0;
+	double ss_tot = 0;
+	for (int i = 0; i < sample_count; i++) {
+		sample_s_t& s = samples[side][i];
+		if (fabs(s.velocity) < min_velocity)
+			continue;
+		double predicted = result.kS * sign(s.velocity) + result.kV * s.velocity +
+		                   result.kA * s.acceleration;
+		ss_res += (s.voltage - predicted) * (s.voltage - predicted);
+		ss_tot += (s.voltage - mean) * (s.voltage - mean);
+	}
+	result.r2 = ss_tot > 0 ? 1 - ss_res / ss_tot : 0;
+
+	return result;
+}
+
+void save() {
+	if (!pros::usd::is_installed()) {
+		printf("ARMS WARNING: no SD card, characterization results not saved\n");
+		return;
+	}
+
+	FILE* file = fopen("/usd/arms_feedforward.txt", "w");
+	if (file) {
+		fprintf(file, "#define LEFT_FEEDFORWARD %f, %f, %f\n", fits[0].kS,
+		        fits[0].kV, fits[0].kA);
+		fprintf(file, "#define RIGHT_FEEDFORWARD %f, %f, %f\n", fits[1].kS,
+		        fits[1].kV, fits[1].kA);
+		fclose(file);
+	}
+
+	file = fopen("/usd/arms_characterization.csv", "w");
+	if (file) {
+		fprintf(file, "voltage,left_velocity,left_acceleration,right_velocity,"
+		              "right_acceleration\n");
+		for (int i = 0; i < sample_count; i++)
+			fprintf(file, "%f,%f,%f,%f,%f\n", samples[0][i].voltage,
+			        samples[0][i].velocity, samples[0][i].acceleration,
+			        samples[1][i].velocity, samples[1][i].acceleration);
+		fclose(file);
+	}
+}
+
+void run(double ramp_rate, double step_voltage, double max_distance) {
+	pid::mode = MANUAL; // keep the chassis task off the motors
+	sample_count = 0;
+
+	// quasistatic ramps, slow enough that acceleration is negligible
+	test(0, ramp_rate, 1, 60000, max_distance);
+	test(0, ramp_rate, -1, 60000, max_distance);
+
+	// steps, mostly acceleration
+	test(step_voltage, 0, 1, 3000, max_distance);
+	test(step_voltage, 0, -1, 3000, max_distance);
+
+	pid::mode = DISABLE;
+
+	const char* names[] = {"LEFT", "RIGHT"};
+	for (int side = 0; side < 2; side++) {
+		fits[side] = fit(side);
+		printf("ARMS characterization %s: kS %f, kV %f, kA %f (r2 %.3f, %d "
+		       "samples)\n",
+		       names[side], fits[side].kS, fits[side].kV, fits[side].kA,
+		       fits[side].r2, fits[side].samples);
+	}
+
+	save();
+}
+
+fit_s_t getFit(int side) {
+	return fits[side ? 1 : 0];
+}
+
+} // namespace arms::characterization
@@ -2,6 +2,7 @@
 #include "api.h"
 #include "pros/motors.h"
 
+#include <atomic>
 #include <tuple>
 
 namespace arms::chassis {
@@ -10,6 +11,14 @@ namespace arms::chassis {
 std::shared_ptr<pros::Motor_Group> leftMotors;
 std::shared_ptr<pros::Motor_Group> rightMotors;
 
+// holonomic chassis motors, the sides above hold the same motors
+ChassisType_e_t chassis_type = DIFFERENTIAL;
+std::shared_ptr<pros::Motor_Group> frontLeftMotors;
+std::shared_ptr<pros::Motor_Group> frontRightMotors;
+std::shared_ptr<pros::Motor_Group> backLeftMotors;
+std::shared_ptr<pros::Motor_Group> backRightMotors;
+std::shared_ptr<pros::Motor_Group> strafeMotors;
+
 // slew control (autonomous only)
 double slew_step; // smaller number = more slew
 
@@ -30,29 +39,149 @@ double leftPrev = 0;
 double rightPrev = 0;
 double leftDriveSpeed = 0;
 double rightDriveSpeed = 0;
+double strafeDriveSpeed = 0; // positive to the left
+std::array<double, 4> wheelPrev = {0, 0, 0, 0};
 
 bool previous_end_angle_unknown = false;
 
+// fixed rate scheduler for the chassis task
+Scheduler scheduler;
+
+// time spent in pid::translational() and pid::angular(), only touched by the
+// chassis task and copied out to controller_published behind a sequence
+// number like the scheduler's loop stats
+time_stats_s_t controller_stats;
+time_stats_s_t controller_published;
+std::atomic<uint32_t> controller_seq(0);
+std::atomic<bool> controller_reset(false);
+
+// velocity control
+VelocityMode_e_t velocity_mode;
+double velocity_kp;
+double gearset_rpm;          // free speed of the chassis motors
+double max_velocity = 100;   // wheel speed at 100% speed
+double drive_width = 0;      // inches between the left and right wheels
+bool drive_velocity = false; // tank() and arcade() use velocity control
+bool move_velocity = false;  // the current movement uses velocity control
+
+// feedforward gains {kS, kV, kA} in volts per unit of getMaxVelocity()
+std::array<double, 3> left_feedforward = {0, 0, 0};
+std::array<double, 3> right_feedforward = {0, 0, 0};
+
+// reference wheel velocity and acceleration of the current motion
+std::array<double, 2> reference_velocity = {0, 0}; // left, right
+std::array<double, 2> reference_accel = {0, 0};    // left, right
+
+// motion profiling of 1D moves and turns
+ProfileType_e_t profile_type = PROFILE_NONE;
+double profile_accel;         // in/s^2
+double profile_jerk;          // in/s^3
+double profile_angular_accel; // deg/s^2
+double profile_angular_jerk;  // deg/s^3
+bool profile_move = false;    // the next 2D move is a 1D move
+
+// battery compensation
+bool battery_compensation;
+double nominal_voltage;                     // millivolts
+double battery_voltage = 0;                 // filtered, millivolts
+std::array<double, 3> headroom = {0, 0, 0}; // millivolts, left, right, strafe
+
+// weight of the newest battery measurement
+#define BATTERY_FILTER 0.02
+
+/**************************************************/
+// feedforward
+void setReference(std::array<double, 2> velocity,
+                  std::array<double, 2> acceleration) {
+	reference_velocity = velocity;
+	reference_accel = acceleration;
+}
+
+void clearReference() {
+	reference_velocity = {0, 0};
+	reference_accel = {0, 0};
+}
+
+// feedforward voltage in percent, static friction is applied in the direction
+// of the reference velocity or, without one, of the commanded speed
+double feedforward(int side, double velocity, double acceleration,
+                   double speed) {
+	std::array<double, 3>& k = side ? right_feedforward : left_feedforward;
+	double direction = velocity != 0 ? velocity : speed;
+	double sign = direction > 0 ? 1 : (direction < 0 ? -1 : 0);
+	return (k[0] * sign + k[1] * velocity + k[2] * acceleration) * 100 / 12;
+}
+
 /**************************************************/
 // motor control
+double getSpeed(std::shared_ptr<pros::Motor_Group> motor) {
+	double sum = 0;
+	int count = 0;
+	for (int i = 0; i < motor->size(); i++) {
+		double velocity = (*motor)[i].get_actual_velocity();
+		if (velocity == PROS_ERR_F)
+			continue; // skip unplugged motors
+		sum += velocity;
+		count++;
+	}
+	return count ? sum / count / gearset_rpm * 100 : 0;
+}
+
+// side of the chassis a motor group is on, 0 for left, 1 for right and 2 for
+// the center wheel of an h-drive
+int getSide(std::shared_ptr<pros::Motor_Group> motor) {
+	if (motor == strafeMotors)
+		return 2;
+	return motor == rightMotors || motor == frontRightMotors ||
+	       motor == backRightMotors;
+}
+
+void moveVoltage(std::shared_ptr<pros::Motor_Group> motor, double voltage) {
+	// scale the output so it does not depend on the charge of the battery
+	if (battery_compensation && battery_voltage > 0)
+		voltage *= nominal_voltage / battery_voltage;
+
+	// headroom before the motor output saturates
+	int side = getSide(motor);
+	headroom[side] = 12000 - fabs(voltage);
+
+	motor->move_voltage(voltage);
+}
+
 void motorMove(std::shared_ptr<pros::Motor_Group> motor, double speed,
                bool velocity) {
-	if (velocity)
-		motor->move_velocity(speed * (double)motor->get_gearing()[0] / 100);
-	else
-		motor->move_voltage(speed * 120);
+	if (velocity && velocity_mode == VELOCITY_INTERNAL) {
+		motor->move_velocity(speed * gearset_rpm / 100);
+	} else if (velocity) {
+		// feedforward on the target plus feedback on the error, without a kV the
+		// motor is assumed to be linear. The strafe wheel has no gains of its own
+		// and uses the left side's.
+		int side = getSide(motor) == 1;
+		std::array<double, 3>& k = side ? right_feedforward : left_feedforward;
+		double ff = k[1] ? feedforward(side, speed * max_velocity / 100,
+		                               reference_accel[side], speed)
+		                 : speed;
+		moveVoltage(motor, (ff + (speed - getSpeed(motor)) * velocity_kp) * 120);
+	} else {
+		moveVoltage(motor, speed * 120);
+	}
 
 	if (motor == leftMotors)
 		leftPrev = speed;
-	else
+	else if (motor == rightMotors)
 		rightPrev = speed;
 }
 
 void setBrakeMode(pros::motor_brake_mode_e_t b) {
 	leftMotors->set_brake_modes((pros::motor_brake_mode_e_t)b);
 	rightMotors->set_brake_modes((pros::motor_brake_mode_e_t)b);
-	motorMove(leftMotors, 0, true);
-	motorMove(rightMotors, 0, true);
+
+	// the motors' own velocity loop holds the robot still, the ARMS loop would
+	// only push back against the speed it measures
+	leftMotors->move_velocity(0);
+	rightMotors->move_velocity(0);
+	leftPrev = 0;
+	rightPrev = 0;
 }
 
 /**************************************************/
@@ -83,58 +212,86 @@ double slew(double target_speed, double step, double current_speed) {
 
 /**************************************************/
 // settling
-bool settled() {
-	// previous position values
-	static Point p_pos = {0, 0};
-	static double p_ang = 0;
-
-	static int settle_count = 0;
+Point settle_pos = {0, 0};
+double settle_ang = 0;
+int settle_count = 0;
 
-	Point pos = odom::getPosition();
-	double ang = odom::getHeading();
+void updateSettle() {
+	odom::Pose pose = odom::getPose();
+	Point pos = {pose.x, pose.y};
+	double ang = pose.theta * 180 / M_PI;
 
-	if (fabs(pos.x - p_pos.x) > settle_thresh_linear) {
-		p_pos.x = pos.x;
+	if (fabs(pos.x - settle_pos.x) > settle_thresh_linear) {
+		settle_pos.x = pos.x;
 		settle_count = 0;
-	} else if (fabs(pos.y - p_pos.y) > settle_thresh_linear) {
-		p_pos.y = pos.y;
+	} else if (fabs(pos.y - settle_pos.y) > settle_thresh_linear) {
+		settle_pos.y = pos.y;
 		settle_count = 0;
-	} else if (fabs(ang - p_ang) > settle_thresh_angular) {
-		p_ang = ang;
+	} else if (fabs(ang - settle_ang) > settle_thresh_angular) {
+		settle_ang = ang;
 		settle_count = 0;
 	} else {
-		settle_count += 10;
+		settle_count += scheduler.getPeriod();
 	}
+}
 
-	if (settle_count > settle_time)
-		return true;
-	else
-		return false;
+void resetSettle() {
+	odom::Pose pose = odom::getPose();
+	settle_pos = {pose.x, pose.y};
+	settle_ang = pose.theta * 180 / M_PI;
+	settle_count = 0;
 }
 
-void waitUntilFinished(double exit_error) {
-	pros::delay(400); // minimum movement time
+bool settled() {
+	return settle_count > settle_time;
+}
+
+/**************************************************/
+// exit conditions
+double wait_exit_error = 0;
+pros::task_t waiting_task = NULL;
+
+bool finished(double exit_error) {
+	// a slow start to a profile or trajectory is not a settled robot
+	if ((pid::profiled && !pid::profileDone()) ||
+	    (pid::mode == TRAJECTORY && ramsete::isRunning()))
+		return false;
+
+	if (settled())
+		return true;
+
 	switch (pid::mode) {
 	case TRANSLATIONAL:
-		while (odom::getDistanceError(pid::pointTarget) > exit_error &&
-		       !settled()) {
-			pros::delay(10);
-		}
+		if (odom::getDistanceError(pid::pointTarget) > exit_error)
+			return false;
 
 		// if doing a pose movement, make sure we are at the target theta
-		if (pid::angularTarget != 361) {
-			while (fabs(odom::getHeading() - pid::angularTarget) > exit_error &&
-			       !settled())
-				pros::delay(10);
-		}
-
-		break;
+		return pid::angularTarget == 361 ||
+		       fabs(odom::getHeading() - pid::angularTarget) <= exit_error;
 	case ANGULAR:
-		while (fabs(odom::getHeading() - pid::angularTarget) > exit_error &&
-		       !settled())
-			pros::delay(10);
-		break;
+		return fabs(odom::getHeading() - pid::angularTarget) <= exit_error;
+	case FOLLOW:
+		return pursuit::done(exit_error);
+	case TRAJECTORY:
+		return ramsete::done(exit_error);
 	}
+
+	return true;
+}
+
+bool waitUntilFinished(double exit_error, uint32_t timeout) {
+	if (pid::mode == DISABLE)
+		return true;
+
+	// the chassis task checks the exit conditions every tick and notifies us
+	pros::task_t task = pros::c::task_get_current();
+	pros::c::task_notify_clear(task);
+	wait_exit_error = exit_error;
+	waiting_task = task;
+
+	bool done = pros::c::task_notify_take(true, timeout) > 0;
+	waiting_task = NULL;
+	return done;
 }
 
 /**************************************************/
@@ -154,6 +311,9 @@ void move(std::vector<double> target, double max, double exit_error, double lp,
 	double theta =
 	    target.size() == 3 ? fmod(target.at(2), 360) : 361; // setinel value
 
+	// direction the target was projected along, the line of a 1D move
+	double line_heading = odom::getDesiredHeading(true);
+
 	if (flags & TRUE_RELATIVE) {
 		// This will do relative movements based on our current position, and adjust
 		// the coordinate plane based on our current heading
@@ -163,6 +323,7 @@ void move(std::vector<double> target, double max, double exit_error, double lp,
 		double y_new = p.y + x * sin(h) + y * cos(h);
 		x = x_new;
 		y = y_new;
+		line_heading = h;
 		if (target.size() == 3)
 			theta += fmod(odom::getHeading(), 360);
 	} else if (flags & RELATIVE) {
@@ -179,6 +340,8 @@ void move(std::vector<double> target, double max, double exit_error, double lp,
 	} else {
 		if (theta == 361)
 			previous_end_angle_unknown = true;
+		Point p = odom::getPosition();
+		line_heading = atan2(y - p.y, x - p.x);
 	}
 
 	pid::pointTarget = Point{x, y};
@@ -193,6 +356,8 @@ void move(std::vector<double> target, double max, double exit_error, double lp,
 	pid::linearKP = lp;
 	pid::trackingKP = ap;
 	pid::thru = (flags & THRU);
+	move_velocity = (flags & VELOCITY);
+	clearReference();
 	pid::reverse = (flags & REVERSE);
 	pid::canReverse = false;
 
@@ -200,6 +365,23 @@ void move(std::vector<double> target, double max, double exit_error, double lp,
 	pid::in_lin = 0;
 	pid::in_ang = 0;
 
+	// follow a profile along the line to the target of a 1D move
+	pid::profiled = false;
+	if (profile_move && profile_type != PROFILE_NONE &&
+	    chassis_type == DIFFERENTIAL) {
+		odom::Pose pose = odom::getPose();
+		double h = line_heading;
+		double distance =
+		    (x - pose.x) * cos(h) + (y - pose.y) * sin(h); // along the line
+		pid::startProfile(Profile(profile_type, distance,
+		                          max * getMaxVelocity() / 100, profile_accel,
+		                          profile_jerk),
+		                  h);
+	}
+	profile_move = false;
+
+	resetSettle();
+
 	if (!(flags & ASYNC)) {
 		waitUntilFinished(exit_error);
 		pid::mode = DISABLE;
@@ -225,18 +407,22 @@ void move(std::vector<double> target, MoveFlags flags) {
 // 1D movement
 void move(double target, double max, double exit_error, double lp,
           MoveFlags flags) {
+	profile_move = true;
 	move({target, 0}, max, exit_error, lp, -1, flags | RELATIVE);
 }
 
 void move(double target, double max, double exit_error, MoveFlags flags) {
+	profile_move = true;
 	move({target, 0}, max, exit_error, -1, -1, flags | RELATIVE);
 }
 
 void move(double target, double max, MoveFlags flags) {
+	profile_move = true;
 	move({target, 0}, max, linear_exit_error, -1, -1, flags | RELATIVE);
 }
 
 void move(double target, MoveFlags flags) {
+	profile_move = true;
 	move({target, 0}, 100, linear_exit_error, -1, -1, flags | RELATIVE);
 }
 
@@ -270,8 +456,25 @@ void turn(double target, double max, double exit_error, double ap,
 	pid::angularTarget = true_target;
 	maxSpeed = max;
 	pid::angularKP = ap;
+	move_velocity = (flags & VELOCITY);
+	clearReference();
 	pid::in_ang = 0; // reset the integral value to zero
 
+	// follow a profile from the current heading, the wheels travel along an arc
+	// of half the track width
+	pid::profiled = false;
+	double radius = drive_width / 2;
+	if (profile_type != PROFILE_NONE && chassis_type == DIFFERENTIAL &&
+	    radius > 0) {
+		double to_degrees = 180 / M_PI / radius;
+		pid::startProfile(Profile(profile_type, true_target - odom::getHeading(),
+		                          max * getMaxVelocity() / 100 * to_degrees,
+		                          profile_angular_accel, profile_angular_jerk),
+		                  odom::getHeading(true));
+	}
+
+	resetSettle();
+
 	if (!(flags & ASYNC)) {
 		waitUntilFinished(exit_error);
 		pid::mode = DISABLE;
@@ -360,20 +563,281 @@ void moveVectorPath(double magnitude, double angle, MoveFlags flags) {
 	moveVectorPath(magnitude, angle, 100, linear_exit_error, -1, -1, flags);
 }
 
+/**************************************************/
+// path following
+
+// run the path or trajectory the follower was started with
+void runPath(int mode, Point end, double exit_error, MoveFlags flags) {
+	move_velocity = (flags & VELOCITY);
+	pid::profiled = false;
+	previous_end_angle_unknown = true;
+	odom::setDesiredPosition(end);
+	pid::pointTarget = end;
+	pid::angularTarget = 361;
+	pid::mode = mode;
+
+	resetSettle();
+
+	if (!(flags & ASYNC)) {
+		waitUntilFinished(exit_error);
+		pid::mode = DISABLE;
+		if (!(flags & THRU))
+			chassis::setBrakeMode(pros::E_MOTOR_BRAKE_BRAKE);
+	}
+}
+
+bool canFollow() {
+	if (chassis_type != DIFFERENTIAL) {
+		printf("ARMS ERROR: path following needs a differential chassis\n");
+		return false;
+	}
+	if (drive_width <= 0) {
+		printf("ARMS ERROR: path following needs DRIVE_WIDTH to steer\n");
+		return false;
+	}
+	return true;
+}
+
+void follow(std::vector<Point> path, double max, double exit_error,
+            MoveFlags flags) {
+	if (!canFollow() ||
+	    !pursuit::start(path, max * getMaxVelocity() / 100, flags & REVERSE))
+		return;
+
+	maxSpeed = max;
+	runPath(FOLLOW, path.back(), exit_error, flags);
+}
+
+void follow(std::vector<Point> path, double max, MoveFlags flags) {
+	follow(path, max, linear_exit_error, flags);
+}
+
+void follow(std::vector<Point> path, MoveFlags flags) {
+	follow(path, 100, linear_exit_error, flags);
+}
+
+void follow(const Path& path, double max, double exit_error,
+            MoveFlags flags) {
+	if (!canFollow() ||
+	    !pursuit::start(path, max * getMaxVelocity() / 100, flags & REVERSE))
+		return;
+
+	path_sample_s_t end = path.sample(path.getLength());
+	maxSpeed = max;
+	runPath(FOLLOW, {end.x, end.y}, exit_error, flags);
+}
+
+void follow(const Path& path, double max, MoveFlags flags) {
+	follow(path, max, linear_exit_error, flags);
+}
+
+void follow(const Path& path, MoveFlags flags) {
+	follow(path, 100, linear_exit_error, flags);
+}
+
+void followTrajectory(std::vector<Point> path, double max, double exit_error,
+                      MoveFlags flags) {
+	if (!canFollow() ||
+	    !ramsete::start(path, max * getMaxVelocity() / 100, flags & REVERSE))
+		return;
+
+	// leave room for the feedback above the trajectory velocity
+	maxSpeed = 100;
+	runPath(TRAJECTORY, path.back(), exit_error, flags);
+}
+
+void followTrajectory(std::vector<Point> path, double max, MoveFlags flags) {
+	followTrajectory(path, max, linear_exit_error, flags);
+}
+
+void followTrajectory(std::vector<Point> path, MoveFlags flags) {
+	followTrajectory(path, 100, linear_exit_error, flags);
+}
+
+void followTrajectory(const Path& path, double max, double exit_error,
+                      MoveFlags flags) {
+	if (!canFollow() ||
+	    !ramsete::start(path, max * getMaxVelocity() / 100, flags & REVERSE))
+		return;
+
+	path_sample_s_t end = path.sample(path.getLength());
+	maxSpeed = 100;
+	runPath(TRAJECTORY, {end.x, end.y}, exit_error, flags);
+}
+
+void followTrajectory(const Path& path, double max, MoveFlags flags) {
+	followTrajectory(path, max, linear_exit_error, flags);
+}
+
+void followTrajectory(const Path& path, MoveFlags flags) {
+	followTrajectory(path, 100, linear_exit_error, flags);
+}
+
+void followTrajectory(const ramsete::trajectory_point_s_t* trajectory,
+                      int size, double exit_error, MoveFlags flags) {
+	if (!canFollow() || size <= 0)
+		return;
+
+	ramsete::start(trajectory, size);
+	maxSpeed = 100;
+	runPath(TRAJECTORY, {trajectory[size - 1].x, trajectory[size - 1].y},
+	        exit_error, flags);
+}
+
+void followTrajectory(const ramsete::trajectory_point_s_t* trajectory,
+                      int size, MoveFlags flags) {
+	followTrajectory(trajectory, size, linear_exit_error, flags);
+}
+
+/**************************************************/
+// controller timing
+void publishControllerStats() {
+	controller_seq.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	controller_published = controller_stats;
+	std::atomic_thread_fence(std::memory_order_release);
+	controller_seq.fetch_add(1, std::memory_order_relaxed);
+}
+
+void addControllerTime(double time) {
+	addTime(controller_stats, time);
+	publishControllerStats();
+}
+
+/**************************************************/
+// holonomic control
+void holonomicMove(std::array<double, 3> speeds, bool velocity) {
+	double forward = speeds[0];
+	double left = speeds[1];
+	double ccw = speeds[2];
+
+	// inverse kinematics
+	std::array<double, 4> wheels;
+	std::array<std::shared_ptr<pros::Motor_Group>, 4> groups;
+	int count;
+	if (chassis_type == H_DRIVE) {
+		wheels = {forward - ccw, forward + ccw, left, 0};
+		groups = {leftMotors, rightMotors, strafeMotors, nullptr};
+		count = 3;
+	} else {
+		wheels = {forward - left - ccw, forward + left + ccw, forward + left - ccw,
+		          forward - left + ccw};
+		groups = {frontLeftMotors, frontRightMotors, backLeftMotors,
+		          backRightMotors};
+		count = 4;
+	}
+
+	// scale every wheel by the same amount to keep the direction of motion
+	double largest = 0;
+	for (int i = 0; i < count; i++)
+		largest = std::max(largest, fabs(wheels[i]));
+	if (largest > maxSpeed)
+		for (int i = 0; i < count; i++)
+			wheels[i] *= maxSpeed / largest;
+
+	for (int i = 0; i < count; i++) {
+		wheels[i] = slew(wheels[i], slew_step, wheelPrev[i]);
+		wheelPrev[i] = wheels[i];
+		motorMove(groups[i], wheels[i], velocity);
+	}
+}
+
+void holonomicTask(bool velocity) {
+	std::array<double, 3> speeds; // forward, left, counterclockwise
+
+	uint64_t controller_start = pros::micros();
+	if (pid::mode == TRANSLATIONAL) {
+		speeds = pid::holonomic();
+	} else if (pid::mode == ANGULAR) {
+		speeds = {0, 0, pid::angular()[1]};
+	} else {
+		speeds = {(leftDriveSpeed + rightDriveSpeed) / 2, strafeDriveSpeed,
+		          (rightDriveSpeed - leftDriveSpeed) / 2};
+	}
+	if (pid::mode != DISABLE)
+		addControllerTime((pros::micros() - controller_start) / 1000.0);
+
+	holonomicMove(speeds, velocity);
+}
+
 /**************************************************/
 // task control
 int chassisTask() {
 	while (1) {
-		pros::delay(10);
+		scheduler.wait();
+
+		// clear the controller timing when another task asked for it
+		if (controller_reset.exchange(false)) {
+			controller_stats = time_stats_s_t();
+			publishControllerStats();
+		}
+
+		// in fused mode the pose is updated here so the controller always sees
+		// the pose from this tick
+		if (odom::fused)
+			odom::update();
+
+		updateSettle();
+
+		// filter the battery voltage, it dips with every current spike
+		double battery = pros::battery::get_voltage();
+		if (battery > 0 && battery != PROS_ERR) {
+			if (battery_voltage == 0)
+				battery_voltage = battery;
+			battery_voltage += (battery - battery_voltage) * BATTERY_FILTER;
+		}
+
+		// wake the task waiting on the current movement once it is finished
+		if (waiting_task != NULL && finished(wait_exit_error)) {
+			pros::task_t task = waiting_task;
+			waiting_task = NULL;
+			pros::c::task_notify(task);
+		}
+
+		// something else is driving the motors
+		if (pid::mode == MANUAL)
+			continue;
+
+		bool velocity = pid::mode == DISABLE ? drive_velocity : move_velocity;
+
+		if (chassis_type != DIFFERENTIAL) {
+			holonomicTask(velocity);
+			continue;
+		}
 
 		std::array<double, 2> speeds = {0, 0}; // left, right
 
+		uint64_t controller_start = pros::micros();
 		if (pid::mode == TRANSLATIONAL)
 			speeds = pid::translational();
 		else if (pid::mode == ANGULAR)
 			speeds = pid::angular();
+		else if (pid::mode == FOLLOW)
+			pursuit::update(); // steers through the reference alone
+		else if (pid::mode == TRAJECTORY)
+			ramsete::update();
 		else
 			speeds = {leftDriveSpeed, rightDriveSpeed};
+		if (pid::mode != DISABLE)
+			addControllerTime((pros::micros() - controller_start) / 1000.0);
+
+		// a profile's or path's velocity drives the wheels directly when there is
+		// no characterized kV to turn it into voltage
+		if ((pid::profiled && pid::mode != DISABLE) || pid::mode == FOLLOW ||
+		    pid::mode == TRAJECTORY) {
+			if (velocity || !left_feedforward[1])
+				speeds[0] += reference_velocity[0] * 100 / max_velocity;
+			if (velocity || !right_feedforward[1])
+				speeds[1] += reference_velocity[1] * 100 / max_velocity;
+		}
+
+		// feedforward, velocity control applies its own
+		if (pid::mode != DISABLE && !velocity) {
+			speeds[0] += feedforward(0, reference_velocity[0], reference_accel[0],
+			                         speeds[0]);
+			speeds[1] += feedforward(1, reference_velocity[1], reference_accel[1],
+			                         speeds[1]);
+		}
 
 		// speed limiting
 		speeds[0] = limitSpeed(speeds[0], maxSpeed);
@@ -384,8 +848,39 @@ int chassisTask() {
 		speeds[1] = slew(speeds[1], slew_step, rightPrev);
 
 		// output
-		motorMove(leftMotors, speeds[0], false);
-		motorMove(rightMotors, speeds[1], false);
+		motorMove(leftMotors, speeds[0], velocity);
+		motorMove(rightMotors, speeds[1], velocity);
+	}
+}
+
+loop_stats_s_t getLoopStats() {
+	return scheduler.getStats();
+}
+
+time_stats_s_t getControllerStats() {
+	// retry if the chassis task published while we were reading
+	while (true) {
+		uint32_t before = controller_seq.load(std::memory_order_acquire);
+		time_stats_s_t copy = controller_published;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!(before & 1) &&
+		    controller_seq.load(std::memory_order_relaxed) == before)
+			return copy;
+	}
+}
+
+void resetLoopStats() {
+	scheduler.resetStats();
+	controller_reset.store(true);
+}
+
+int timingTask() {
+	while (true) {
+		pros::delay(1000);
+		printStats("chassis", getLoopStats());
+		printStats("controller", getControllerStats());
+		if (!odom::fused)
+			printStats("odom", odom::getLoopStats());
 	}
 }
 
@@ -396,7 +891,16 @@ void init(std::initializer_list<int8_t> leftMotors,
           pros::motor_gearset_e_t gearset, double slew_step,
           double linear_exit_error, double angular_exit_error,
           double settle_thresh_linear, double settle_thresh_angular,
-          int settle_time, double min_linear_speed, double min_angular_speed) {
+          int settle_time, double min_linear_speed, double min_angular_speed,
+          int period, bool timing_debug, double wheel_diameter,
+          double gear_ratio, VelocityMode_e_t velocity_mode,
+          double velocity_kp, std::array<double, 3> left_feedforward,
+          std::array<double, 3> right_feedforward, bool battery_compensation,
+          double nominal_voltage, ChassisType_e_t type,
+          std::initializer_list<int8_t> strafeMotors,
+          ProfileType_e_t profile_type, double profile_accel,
+          double profile_jerk, double profile_angular_accel,
+          double profile_angular_jerk, double drive_width) {
 
 	// assign constants
 	chassis::slew_step = slew_step;
@@ -405,6 +909,39 @@ void init(std::initializer_list<int8_t> leftMotors,
 	chassis::settle_thresh_linear = settle_thresh_linear;
 	chassis::settle_thresh_angular = settle_thresh_angular;
 	chassis::settle_time = settle_time;
+	chassis::drive_width = drive_width;
+	scheduler.setPeriod(period);
+
+	// velocity control
+	switch (gearset) {
+	case pros::E_MOTOR_GEARSET_36:
+		gearset_rpm = 100;
+		break;
+	case pros::E_MOTOR_GEARSET_06:
+		gearset_rpm = 600;
+		break;
+	default:
+		gearset_rpm = 200;
+		break;
+	}
+	if (wheel_diameter > 0)
+		chassis::max_velocity =
+		    gearset_rpm * gear_ratio * M_PI * wheel_diameter / 60; // in/s
+	chassis::velocity_mode = velocity_mode;
+	chassis::velocity_kp = velocity_kp;
+	chassis::left_feedforward = left_feedforward;
+	chassis::right_feedforward = right_feedforward;
+	chassis::battery_compensation = battery_compensation;
+	chassis::nominal_voltage = nominal_voltage * 1000;
+
+	// motion profiling
+	chassis::profile_type = profile_type;
+	chassis::profile_accel = profile_accel;
+	chassis::profile_jerk = profile_jerk;
+	chassis::profile_angular_accel = profile_angular_accel;
+	chassis::profile_angular_jerk = profile_angular_jerk;
+	if (profile_type != PROFILE_NONE && wheel_diameter <= 0)
+		printf("ARMS WARNING: motion profiles need the wheel diameter\n");
 
 	// configure chassis motors
 	chassis::leftMotors =
@@ -414,7 +951,36 @@ void init(std::initializer_list<int8_t> leftMotors,
 	chassis::leftMotors->set_gearing(gearset);
 	chassis::rightMotors->set_gearing(gearset);
 
+	// configure holonomic motors
+	chassis::chassis_type = type;
+	if (type == X_DRIVE || type == MECANUM) {
+		// the front motors of each side are listed first
+		std::vector<int8_t> left(leftMotors);
+		std::vector<int8_t> right(rightMotors);
+		if (left.size() < 2 || right.size() < 2)
+			printf("ARMS ERROR: holonomic chassis needs a front and back motor on "
+			       "each side\n");
+		chassis::frontLeftMotors = std::make_shared<pros::Motor_Group>(
+		    std::vector<int8_t>(left.begin(), left.begin() + left.size() / 2));
+		chassis::backLeftMotors = std::make_shared<pros::Motor_Group>(
+		    std::vector<int8_t>(left.begin() + left.size() / 2, left.end()));
+		chassis::frontRightMotors = std::make_shared<pros::Motor_Group>(
+		    std::vector<int8_t>(right.begin(), right.begin() + right.size() / 2));
+		chassis::backRightMotors = std::make_shared<pros::Motor_Group>(
+		    std::vector<int8_t>(right.begin() + right.size() / 2, right.end()));
+		chassis::frontLeftMotors->set_gearing(gearset);
+		chassis::backLeftMotors->set_gearing(gearset);
+		chassis::frontRightMotors->set_gearing(gearset);
+		chassis::backRightMotors->set_gearing(gearset);
+	} else if (type == H_DRIVE) {
+		chassis::strafeMotors =
+		    std::make_shared<pros::Motor_Group>(std::vector<int8_t>(strafeMotors));
+		chassis::strafeMotors->set_gearing(gearset);
+	}
+
 	pros::Task chassis_task(chassisTask);
+	if (timing_debug)
+		pros::Task timing_task(timingTask, TASK_PRIORITY_MIN);
 
 	chassis::min_linear_speed = min_linear_speed;
 	chassis::min_angular_speed = min_angular_speed;
@@ -422,18 +988,74 @@ void init(std::initializer_list<int8_t> leftMotors,
 
 /**************************************************/
 // operator control
+double getMaxVelocity() {
+	return max_velocity;
+}
+
+double getBatteryVoltage() {
+	return battery_voltage / 1000;
+}
+
+double getDriveWidth() {
+	return drive_width;
+}
+
+double getHeadroom() {
+	double least = std::min(headroom[0], headroom[1]);
+	if (chassis_type == H_DRIVE)
+		least = std::min(least, headroom[2]);
+	return least / 1000;
+}
+
+std::array<double, 2> getWheelVelocity() {
+	return {getSpeed(leftMotors) * max_velocity / 100,
+	        getSpeed(rightMotors) * max_velocity / 100};
+}
+
 void tank(double left_speed, double right_speed, bool velocity) {
 	pid::mode = DISABLE; // turns off autonomous tasks
 	maxSpeed = 100;
-	chassis::leftDriveSpeed = left_speed;
-	chassis::rightDriveSpeed = right_speed;
+	drive_velocity = velocity;
+
+	// convert wheel speeds to percent
+	double scale = velocity ? 100 / max_velocity : 1;
+	chassis::leftDriveSpeed = left_speed * scale;
+	chassis::rightDriveSpeed = right_speed * scale;
+	chassis::strafeDriveSpeed = 0;
 }
 
 void arcade(double vertical, double horizontal, bool velocity) {
 	pid::mode = DISABLE; // turns off autonomous task
 	maxSpeed = 100;
-	chassis::leftDriveSpeed = vertical + horizontal;
-	chassis::rightDriveSpeed = vertical - horizontal;
+	drive_velocity = velocity;
+
+	// convert wheel speeds to percent
+	double scale = velocity ? 100 / max_velocity : 1;
+	chassis::leftDriveSpeed = (vertical + horizontal) * scale;
+	chassis::rightDriveSpeed = (vertical - horizontal) * scale;
+	chassis::strafeDriveSpeed = 0;
+}
+
+void holonomic(double forward, double strafe, double turn, bool fieldCentric,
+               bool velocity) {
+	pid::mode = DISABLE; // turns off autonomous task
+	maxSpeed = 100;
+	drive_velocity = velocity;
+
+	double left = -strafe;
+	if (fieldCentric) {
+		// rotate the field frame input into the robot frame
+		double h = odom::getHeading(true);
+		double robot_forward = forward * cos(h) + left * sin(h);
+		left = -forward * sin(h) + left * cos(h);
+		forward = robot_forward;
+	}
+
+	// convert wheel speeds to percent
+	double scale = velocity ? 100 / max_velocity : 1;
+	chassis::leftDriveSpeed = (forward + turn) * scale;
+	chassis::rightDriveSpeed = (forward - turn) * scale;
+	chassis::strafeDriveSpeed = left * scale;
 }
 
 } // namespace arms::chassis
@@ -0,0 +1,120 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms::odom {
+
+// process noise, as variance added per unit of motion
+#define LINEAR_NOISE 1e-3   // inches^2 per inch travelled
+#define ANGULAR_NOISE 1e-4  // radians^2 per radian turned
+#define SLIP_NOISE 1e-6     // heading radians^2 per inch travelled
+
+// squared mahalanobis distance above which a reading is rejected, the 99%
+// points of the chi-squared distribution with 1 and 2 degrees of freedom
+#define GATE_1D 6.63
+#define GATE_2D 9.21
+
+void Ekf::reset(double x, double y, double theta) {
+	this->x = x;
+	this->y = y;
+	this->theta = theta;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			P[i][j] = 0;
+}
+
+void Ekf::predict(Point delta, double forward, double left,
+                  double delta_angle) {
+	// jacobian of the motion with respect to the pose, only the heading moves
+	// the position
+	double F[3][3] = {{1, 0, -delta.y}, {0, 1, delta.x}, {0, 0, 1}};
+
+	// robot frame noise rotated into the field frame along the average heading
+	double p = theta + delta_angle / 2.0;
+	double c = cos(p);
+	double s = sin(p);
+	double q_forward = LINEAR_NOISE * fabs(forward);
+	double q_left = LINEAR_NOISE * fabs(left);
+	double q_theta = ANGULAR_NOISE * fabs(delta_angle) +
+	                 SLIP_NOISE * (fabs(forward) + fabs(left));
+	double Q[3][3] = {
+	    {c * c * q_forward + s * s * q_left, c * s * (q_forward - q_left), 0},
+	    {c * s * (q_forward - q_left), s * s * q_forward + c * c * q_left, 0},
+	    {0, 0, q_theta}};
+
+	// P = F * P * F^T + Q
+	double FP[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			FP[i][j] = F[i][0] * P[0][j] + F[i][1] * P[1][j] + F[i][2] * P[2][j];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			P[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2] +
+			          Q[i][j];
+
+	x += delta.x;
+	y += delta.y;
+	theta += delta_angle;
+}
+
+bool Ekf::correctHeading(double theta, double variance) {
+	double innovation = theta - this->theta;
+	double S = P[2][2] + variance;
+	if (S <= 0 || innovation * innovation / S > GATE_1D) {
+		rejected++;
+		return false;
+	}
+
+	double K[3] = {P[0][2] / S, P[1][2] / S, P[2][2] / S};
+	x += K[0] * innovation;
+	y += K[1] * innovation;
+	this->theta += K[2] * innovation;
+
+	// P = (I - K * H) * P, H selects the heading
+	double row[3] = {P[2][0], P[2][1], P[2][2]};
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			P[i][j] -= K[i] * row[j];
+	return true;
+}
+
+bool Ekf::correctPosition(double x, double y, double variance) {
+	double innovation[2] = {x - this->x, y - this->y};
+
+	// S = H * P * H^T + R, H selects the position
+	double S[2][2] = {{P[0][0] + variance, P[0][1]},
+	                  {P[1][0], P[1][1] + variance}};
+	double det = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+	if (det <= 0) {
+		rejected++;
+		return false;
+	}
+	double S_inv[2][2] = {{S[1][1] / det, -S[0][1] / det},
+	                      {-S[1][0] / det, S[0][0] / det}};
+
+	double d0 = S_inv[0][0] * innovation[0] + S_inv[0][1] * innovation[1];
+	double d1 = S_inv[1][0] * innovation[0] + S_inv[1][1] * innovation[1];
+	if (innovation[0] * d0 + innovation[1] * d1 > GATE_2D) {
+		rejected++;
+		return false;
+	}
+
+	// K = P * H^T * S^-1
+	double K[3][2];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 2; j++)
+			K[i][j] = P[i][0] * S_inv[0][j] + P[i][1] * S_inv[1][j];
+
+	this->x += K[0][0] * innovation[0] + K[0][1] * innovation[1];
+	this->y += K[1][0] * innovation[0] + K[1][1] * innovation[1];
+	theta += K[2][0] * innovation[0] + K[2][1] * innovation[1];
+
+	// P = (I - K * H) * P
+	double rows[2][3] = {{P[0][0], P[0][1], P[0][2]},
+	                     {P[1][0], P[1][1], P[1][2]}};
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			P[i][j] -= K[i][0] * rows[0][j] + K[i][1] * rows[1][j];
+	return true;
+}
+
+} // namespace arms::odom
@@ -0,0 +1,346 @@
+#include "ARMS/api.h"
+#include "api.h"
+#include "pros/rtos.hpp"
+
+namespace arms::mcl {
+
+#define NUM_PARTICLES 256
+#define MAX_SENSORS 8
+#define MAX_SEGMENTS 64
+
+// distance from the center of the field to the inside of the walls
+#define FIELD_HALF_WIDTH 70.2
+
+#define MM_TO_INCHES (1 / 25.4)
+
+// readings outside this range in millimeters are ignored, the sensor reports
+// 9999 when it sees nothing
+#define MIN_READING 20
+#define MAX_READING 2000
+
+// distance sensor accuracy, 15mm up to 200mm and 5% beyond
+#define MIN_DEVIATION 0.6
+#define DEVIATION_PCT 0.05
+
+// chance a reading is of something not on the map, like another robot
+#define OUTLIER_WEIGHT 0.05
+
+// motion noise added to each particle per update
+#define LINEAR_NOISE 0.05  // standard deviation per inch travelled
+#define ANGULAR_NOISE 0.05 // standard deviation per radian turned
+#define BASE_NOISE 0.05    // inches and radians/10 added even when stationary
+
+// spread of the particles after a reset
+#define RESET_SPREAD 2          // inches
+#define RESET_ANGLE_SPREAD 0.03 // radians
+
+// odometry moves larger than this between updates are treated as a reset
+#define MAX_JUMP 12
+
+// the odometry is only corrected once the particles are this close together
+#define MAX_SPREAD 3
+
+typedef struct particle_s {
+	double x;
+	double y;
+	double theta;
+	double weight;
+} particle_s_t;
+
+typedef struct segment_s {
+	Point a;
+	Point b;
+} segment_s_t;
+
+// preallocated so the filter never touches the heap
+particle_s_t particles[NUM_PARTICLES];
+particle_s_t resampled[NUM_PARTICLES];
+
+segment_s_t segments[MAX_SEGMENTS];
+int segment_count = 0;
+pros::Mutex map_mutex;
+
+sensor_s_t sensors[MAX_SENSORS];
+std::shared_ptr<pros::Distance> distance_sensors[MAX_SENSORS];
+int sensor_count = 0;
+
+Scheduler scheduler(50);
+
+odom::Pose prev_pose;
+odom::Pose estimate;
+double spread = 0;
+bool reseed = true;
+
+// xorshift generator, cheap and without any locking
+uint32_t rng_state = 2463534242;
+
+double uniform() {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state / 4294967296.0;
+}
+
+// approximately normal with a standard deviation of 1, from the sum of
+// uniform samples
+double gaussian() {
+	return (uniform() + uniform() + uniform() + uniform() - 2) * 1.7320508;
+}
+
+// distance along a ray to the nearest segment, or -1 if nothing is hit
+double raycast(double x, double y, double dx, double dy) {
+	double nearest = -1;
+	for (int i = 0; i < segment_count; i++) {
+		double ex = segments[i].b.x - segments[i].a.x;
+		double ey = segments[i].b.y - segments[i].a.y;
+		double denom = dx * ey - dy * ex;
+		if (fabs(denom) < 1e-9)
+			continue; // parallel
+
+		double ax = segments[i].a.x - x;
+		double ay = segments[i].a.y - y;
+		double t = (ax * ey - ay * ex) / denom;
+		double u = (ax * dy - ay * dx) / denom;
+		if (t >= 0 && u >= 0 && u <= 1 && (nearest < 0 || t < nearest))
+			nearest = t;
+	}
+	return nearest;
+}
+
+void spreadParticles(odom::Pose pose) {
+	for (int i = 0; i < NUM_PARTICLES; i++)
+		particles[i] = {pose.x + gaussian() * RESET_SPREAD,
+		                pose.y + gaussian() * RESET_SPREAD,
+		                pose.theta + gaussian() * RESET_ANGLE_SPREAD,
+		                1.0 / NUM_PARTICLES};
+}
+
+// move each particle by the odometry step, expressed in the robot frame
+void move(odom::Pose pose) {
+	double dx = pose.x - prev_pose.x;
+	double dy = pose.y - prev_pose.y;
+	double c = cos(prev_pose.theta);
+	double s = sin(prev_pose.theta);
+	double forward = c * dx + s * dy;
+	double left = -s * dx + c * dy;
+	double delta_angle = pose.theta - prev_pose.theta;
+
+	double distance = sqrt(dx * dx + dy * dy);
+	double linear_sd = BASE_NOISE + LINEAR_NOISE * distance;
+	double angular_sd = BASE_NOISE / 10 + ANGULAR_NOISE * fabs(delta_angle);
+
+	for (int i = 0; i < NUM_PARTICLES; i++) {
+		particle_s_t& p = particles[i];
+		double f = forward + gaussian() * linear_sd;
+		double l = left + gaussian() * linear_sd;
+		double h = p.theta + delta_angle / 2.0;
+		p.x += cos(h) * f - sin(h) * l;
+		p.y += sin(h) * f + cos(h) * l;
+		p.theta += delta_angle + gaussian() * angular_sd;
+	}
+}
+
+// weight each particle by the likelihood of the readings, returns false if
+// there were no usable readings
+bool weigh(double readings[MAX_SENSORS]) {
+	bool any = false;
+	for (int i = 0; i < sensor_count; i++)
+		any = any || readings[i] > 0;
+	if (!any)
+		return false;
+
+	map_mutex.take();
+	double total = 0;
+	for (int i = 0; i < NUM_PARTICLES; i++) {
+		particle_s_t& p = particles[i];
+		double c = cos(p.theta);
+		double s = sin(p.theta);
+		double likelihood = 1;
+
+		for (int j = 0; j < sensor_count; j++) {
+			if (readings[j] <= 0)
+				continue;
+			sensor_s_t& sensor = sensors[j];
+			double x = p.x + c * sensor.forward - s * sensor.left;
+			double y = p.y + s * sensor.forward + c * sensor.left;
+			double angle = p.theta + sensor.angle * M_PI / 180;
+			double expected = raycast(x, y, cos(angle), sin(angle));
+
+			double match = 0;
+			if (expected >= 0) {
+				double sd = fmax(MIN_DEVIATION, readings[j] * DEVIATION_PCT);
+				double error = (readings[j] - expected) / sd;
+				match = exp(-0.5 * error * error);
+			}
+			likelihood *= (1 - OUTLIER_WEIGHT) * match + OUTLIER_WEIGHT;
+		}
+
+		p.weight *= likelihood;
+		total += p.weight;
+	}
+	map_mutex.give();
+
+	if (total <= 0 || !std::isfinite(total)) {
+		reseed = true; // lost, start again from the odometry
+		return false;
+	}
+	for (int i = 0; i < NUM_PARTICLES; i++)
+		particles[i].weight /= total;
+	return true;
+}
+
+// low variance resampling once the weights have degenerated
+void resample() {
+	double sum_squares = 0;
+	for (int i = 0; i < NUM_PARTICLES; i++)
+		sum_squares += particles[i].weight * particles[i].weight;
+	if (1 / sum_squares > NUM_PARTICLES / 2)
+		return; // enough effective particles left
+
+	double step = 1.0 / NUM_PARTICLES;
+	double target = uniform() * step;
+	double cumulative = particles[0].weight;
+	int j = 0;
+	for (int i = 0; i < NUM_PARTICLES; i++) {
+		while (target > cumulative && j < NUM_PARTICLES - 1)
+			cumulative += particles[++j].weight;
+		resampled[i] = particles[j];
+		resampled[i].weight = step;
+		target += step;
+	}
+	for (int i = 0; i < NUM_PARTICLES; i++)
+		particles[i] = resampled[i];
+}
+
+void updateEstimate(uint32_t time) {
+	double x = 0;
+	double y = 0;
+	double sin_sum = 0;
+	double cos_sum = 0;
+	for (int i = 0; i < NUM_PARTICLES; i++) {
+		particle_s_t& p = particles[i];
+		x += p.weight * p.x;
+		y += p.weight * p.y;
+		sin_sum += p.weight * sin(p.theta);
+		cos_sum += p.weight * cos(p.theta);
+	}
+
+	double variance = 0;
+	for (int i = 0; i < NUM_PARTICLES; i++) {
+		particle_s_t& p = particles[i];
+		variance += p.weight * ((p.x - x) * (p.x - x) + (p.y - y) * (p.y - y));
+	}
+
+	// keep the heading continuous with the odometry
+	double theta = atan2(sin_sum, cos_sum);
+	theta += 2 * M_PI * round((prev_pose.theta - theta) / (2 * M_PI));
+
+	estimate = {x, y, theta, time};
+	spread = sqrt(variance);
+}
+
+int mclTask() {
+	double readings[MAX_SENSORS];
+
+	while (true) {
+		scheduler.wait();
+
+		odom::Pose pose = odom::getPose();
+		for (int i = 0; i < sensor_count; i++) {
+			int32_t reading = distance_sensors[i]->get();
+			if (reading == PROS_ERR || reading < MIN_READING ||
+			    reading > MAX_READING)
+				readings[i] = -1;
+			else
+				readings[i] = reading * MM_TO_INCHES;
+		}
+
+		double jump = sqrt((pose.x - prev_pose.x) * (pose.x - prev_pose.x) +
+		                   (pose.y - prev_pose.y) * (pose.y - prev_pose.y));
+		if (reseed || jump > MAX_JUMP) {
+			spreadParticles(pose);
+			reseed = false;
+		} else {
+			move(pose);
+		}
+		prev_pose = pose;
+
+		if (!weigh(readings))
+			continue;
+		updateEstimate(pose.time);
+		resample();
+
+		// the particles only pin down the position, the imu is a better source
+		// of heading
+		if (spread < MAX_SPREAD) {
+			odom::Pose shift = odom::correct({estimate.x, estimate.y}, pose.time,
+			                                 spread * spread);
+
+			// the particles already know about the correction, keep it out of the
+			// next odometry step
+			prev_pose.x += shift.x;
+			prev_pose.y += shift.y;
+			prev_pose.theta += shift.theta;
+		}
+	}
+}
+
+void addSegment(Point a, Point b) {
+	map_mutex.take();
+	if (segment_count < MAX_SEGMENTS)
+		segments[segment_count++] = {a, b};
+	else
+		printf("ARMS WARNING: the localization map is full\n");
+	map_mutex.give();
+}
+
+void clearMap() {
+	map_mutex.take();
+	segment_count = 0;
+	map_mutex.give();
+}
+
+void reset() {
+	reseed = true;
+}
+
+odom::Pose getEstimate() {
+	return estimate;
+}
+
+double getSpread() {
+	return spread;
+}
+
+loop_stats_s_t getLoopStats() {
+	return scheduler.getStats();
+}
+
+void init(std::initializer_list<sensor_s_t> sensors, int period) {
+	sensor_count = 0;
+	for (sensor_s_t sensor : sensors) {
+		if (sensor_count >= MAX_SENSORS)
+			break;
+		mcl::sensors[sensor_count] = sensor;
+		distance_sensors[sensor_count] =
+		    std::make_shared<pros::Distance>(sensor.port);
+		sensor_count++;
+	}
+	if (sensor_count == 0)
+		return;
+
+	// field walls
+	double w = FIELD_HALF_WIDTH;
+	addSegment({-w, -w}, {w, -w});
+	addSegment({w, -w}, {w, w});
+	addSegment({w, w}, {-w, w});
+	addSegment({-w, w}, {-w, -w});
+
+	scheduler.setPeriod(period);
+	prev_pose = odom::getPose();
+
+	// below the control loops so the ray casting never delays them
+	pros::Task mcl_task(mclTask, TASK_PRIORITY_DEFAULT - 1);
+}
+
+} // namespace arms::mcl
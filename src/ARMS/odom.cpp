@@ -2,6 +2,8 @@
 #include "api.h"
 #include "pros/rtos.hpp"
 
+#include <atomic>
+
 namespace arms::odom {
 
 config_data_s_t configData;
@@ -14,10 +16,36 @@ std::shared_ptr<pros::Rotation> middleRotation = nullptr;
 std::shared_ptr<pros::ADIEncoder> rightADIEncoder = nullptr;
 std::shared_ptr<pros::ADIEncoder> leftADIEncoder = nullptr;
 std::shared_ptr<pros::ADIEncoder> middleADIEncoder = nullptr;
+std::shared_ptr<pros::Gps> gps = nullptr;
 
 // output the odometry data to the terminal
 bool debug;
 
+// fixed rate scheduler for the odometry task
+Scheduler scheduler;
+
+// odometry is updated by the chassis task instead of its own task
+bool fused = false;
+
+// fastest data rate of the rotation sensor and imu in milliseconds. The
+// readings are only copied to the brain every 10ms, so polling this fast
+// picks up each new sample sooner but does not get them any more often.
+#define SENSOR_DATA_RATE 5
+
+// poll at the sensor data rate and only integrate new samples
+bool sensor_rate = false;
+
+// integrate anyway after this many milliseconds without a new encoder sample,
+// so the imu is still read while the wheels are stopped
+#define SAMPLE_TIMEOUT 10
+
+// weight of the newest interval in the measured update rate
+#define RATE_FILTER 0.05
+
+// filtered time between integrated updates in milliseconds
+uint64_t prev_update_time = 0;
+double update_period = 0;
+
 // tracker wheel configuration
 double track_width;
 double left_right_distance;
@@ -25,10 +53,37 @@ double middle_distance;
 double tpi;
 double middle_tpi;
 
-// odom position values
+// odom position values, only used by the odometry update
 Point position;
 double heading;
 
+// serializes the odometry update and resets
+pros::Mutex state_mutex;
+
+// filtered velocity and acceleration in the field frame
+Twist velocity = {0, 0, 0};
+Twist acceleration = {0, 0, 0};
+
+// published poses, the writer fills the buffer readers are not pointed at and
+// then flips the index, so a reader never has to wait for the writer
+typedef struct pose_buffer_s {
+	std::atomic<uint32_t> seq;
+	Pose pose;
+	Twist velocity;
+	Twist acceleration;
+} pose_buffer_s_t;
+
+pose_buffer_s_t pose_buffers[2];
+std::atomic<uint32_t> pose_index(0);
+
+// history of published poses, entry n is stored in slot n % HISTORY_SIZE
+#define HISTORY_SIZE 128
+// entries close to being overwritten that readers skip
+#define HISTORY_MARGIN 4
+Pose history[HISTORY_SIZE];
+std::atomic<uint32_t> history_head(0);  // number of entries ever written
+std::atomic<uint32_t> history_start(0); // first entry since the last reset
+
 Point desired_pos = {0, 0};
 double desired_heading = 0;
 
@@ -38,13 +93,168 @@ double prev_right_pos = 0;
 double prev_middle_pos = 0;
 double prev_heading = 0;
 
+// most motors read from a motor group
+#define MAX_GROUP_MOTORS 8
+
+// how the motor encoders of a group are combined
+MotorEncoderMode_e_t motorEncoderMode = MOTOR_ENCODER_FIRST;
+
+// how each step is integrated into the position
+Integrator_e_t integrator = INTEGRATOR_ARC;
+
+// fuse the odometry with the imu and gps in a kalman filter
+bool filter = false;
+Ekf ekf;
+
+#define METERS_TO_INCHES 39.3701
+
+// heading variance of the imu in radians^2
+#define IMU_VARIANCE 1e-5
+
+// the gps is read at its data rate so a reading is not fused twice
+#define GPS_PERIOD 20
+// gps readings with a larger reported error in meters are ignored
+#define GPS_MAX_ERROR 0.1
+// floor on the gps error in meters, the reported error can be optimistic
+#define GPS_MIN_ERROR 0.01
+uint32_t prev_gps_time = 0;
+
+TwistSource_e_t twistSource = TWIST_DIFFERENTIATOR;
+
+// alpha-beta-gamma tracking filter gains, the fading memory gains for a
+// forgetting factor of 0.7: 1 - t^3, 1.5 (1 - t)^2 (1 + t) and 0.5 (1 - t)^3
+#define TRACK_ALPHA 0.657
+#define TRACK_BETA 0.2295
+#define TRACK_GAMMA 0.0135
+
+// weight of the newest sample when differentiating sensor velocities
+#define ACCEL_FILTER 0.2
+
+// state of one axis of the tracking filter
+typedef struct tracker_s {
+	double value = 0;
+	double rate = 0;
+	double accel = 0;
+} tracker_s_t;
+
+// the filter follows the motion accumulated by the odometry steps, so resets
+// and corrections of the position never show up as velocity
+tracker_s_t trackers[3];
+double motion[3] = {0, 0, 0};
+uint64_t prev_twist_time = 0;
+
+// fraction of an external position correction applied without the filter
+#define CORRECTION_GAIN 0.2
+
+// estimate the gyro bias while the robot is still
+bool bias_correction = false;
+
+// the robot is still once the encoders move less than STILL_DISTANCE inches
+// per update for STILL_TIME milliseconds
+#define STILL_DISTANCE 0.002
+#define STILL_TIME 100
+// shortest still interval whose drift is used as a bias estimate
+#define BIAS_WINDOW 500
+// weight of the newest bias estimate
+#define BIAS_FILTER 0.3
+// largest believable bias in degrees per millisecond (0.015 deg/s), about
+// the drift of a v5 imu. Anything faster is slow turning, like the tail of a
+// turn, that the encoders were too still to see.
+#define MAX_BIAS 1.5e-5
+
+// most imus fused into the heading
+#define MAX_IMUS 4
+
+// an imu whose decaying disagreement with the others grows past FAULT_ERROR
+// degrees is dropped until the next heading reset
+#define FAULT_ERROR 3
+#define FAULT_DECAY 0.99
+// weight of the newest squared residual in the noise of each imu
+#define NOISE_FILTER 0.05
+// floor on the noise of an imu in degrees^2 per update
+#define MIN_NOISE 1e-6
+// degrees an imu has to turn before its scale is trusted, and the largest
+// scale error believed
+#define SCALE_ROTATION 360
+#define MAX_SCALE_ERROR 0.05
+
+typedef struct imu_state_s {
+	std::shared_ptr<pros::Imu> imu;
+	bool connected = false;   // prev_rotation holds a valid reading
+	bool faulted = false;     // diverged from the other imus
+	bool valid = false;       // read successfully this update
+	double prev_rotation = 0; // last raw rotation
+	double increment = 0;     // corrected rotation this update
+	double bias = 0;          // degrees per millisecond
+	double scale = 1;         // relative to the fused rotation
+	double drift = 0;         // raw rotation since the robot stopped
+	double error = 0;         // decaying disagreement with the other imus
+	double noise = 0;         // filtered squared residual
+	double scale_num = 0;     // least squares sums for the scale
+	double scale_den = 0;
+	double turned = 0; // degrees turned while estimating the scale
+} imu_state_s_t;
+
+imu_state_s_t imus[MAX_IMUS];
+int imu_count = 0;
+double imu_rotation = 0; // fused rotation in degrees, clockwise like the imu
+uint32_t prev_imu_time = 0;
+uint32_t move_time = 0; // last time the encoders moved
+bool still = false;
+uint32_t still_time = 0; // time the robot stopped
+
+double getMotorEncoder(std::shared_ptr<pros::Motor_Group> motors) {
+	// read each motor individually, get_positions() allocates a vector
+	std::array<double, MAX_GROUP_MOTORS> positions;
+	int size = motors->size();
+	int count = 0;
+	for (int i = 0; i < size && count < MAX_GROUP_MOTORS; i++) {
+		double position = (*motors)[i].get_position();
+		if (position == PROS_ERR_F)
+			continue; // skip unplugged motors
+
+		positions[count++] = position;
+		if (motorEncoderMode == MOTOR_ENCODER_FIRST)
+			break;
+	}
+
+	if (count == 0)
+		return 0;
+
+	switch (motorEncoderMode) {
+	case MOTOR_ENCODER_MEAN: {
+		double sum = 0;
+		for (int i = 0; i < count; i++)
+			sum += positions[i];
+		return sum / count;
+	}
+	case MOTOR_ENCODER_MEDIAN: {
+		// insertion sort, the groups are tiny
+		for (int i = 1; i < count; i++) {
+			double value = positions[i];
+			int j = i - 1;
+			while (j >= 0 && positions[j] > value) {
+				positions[j + 1] = positions[j];
+				j--;
+			}
+			positions[j + 1] = value;
+		}
+		if (count % 2)
+			return positions[count / 2];
+		return (positions[count / 2 - 1] + positions[count / 2]) / 2;
+	}
+	default:
+		return positions[0];
+	}
+}
+
 double getLeftEncoder() {
 	if (configData.encoderType == ENCODER_ADI && leftADIEncoder != nullptr) {
 		return leftADIEncoder->get_value();
 	} else if (leftRotation != nullptr) {
 		return leftRotation->get_position();
 	} else if (chassis::leftMotors) {
-		return chassis::leftMotors->get_positions()[0];
+		return getMotorEncoder(chassis::leftMotors);
 	}
 	return 0;
 }
@@ -55,7 +265,7 @@ double getRightEncoder() {
 	} else if (rightRotation != nullptr) {
 		return rightRotation->get_position();
 	} else if (chassis::rightMotors) {
-		return chassis::rightMotors->get_positions()[0];
+		return getMotorEncoder(chassis::rightMotors);
 	}
 	return 0;
 }
@@ -69,86 +279,529 @@ double getMiddleEncoder() {
 	return 0;
 }
 
-int odomTask() {
+double median(double* values, int count) {
+	// insertion sort, there are only a handful of values
+	for (int i = 1; i < count; i++) {
+		double value = values[i];
+		int j = i - 1;
+		while (j >= 0 && values[j] > value) {
+			values[j + 1] = values[j];
+			j--;
+		}
+		values[j + 1] = value;
+	}
+	if (count % 2)
+		return values[count / 2];
+	return (values[count / 2 - 1] + values[count / 2]) / 2;
+}
 
-	position.x = 0;
-	position.y = 0;
-	heading = 0;
+// read an imu and store its rotation this update with the bias and scale
+// removed, zero while the robot is still
+void readImu(imu_state_s_t& s, bool was_still, uint32_t window, uint32_t dt) {
+	s.valid = false;
+	double raw = s.imu->get_rotation();
+	if (raw == PROS_ERR_F) {
+		s.connected = false;
+		return;
+	}
+	if (!s.connected) {
+		// (re)connected, start measuring from this reading
+		s.prev_rotation = raw;
+		s.connected = true;
+		s.increment = 0;
+		s.valid = true;
+		return;
+	}
+	double raw_increment = raw - s.prev_rotation;
+	s.prev_rotation = raw;
 
-	while (true) {
-		// get positions of each encoder
-		double left_pos = getLeftEncoder();
-		double right_pos = getRightEncoder();
-		double middle_pos = configData.middleEncoderPort ? getMiddleEncoder() : 0;
-
-		// calculate change in each encoder
-		double delta_left = (left_pos - prev_left_pos) / tpi;
-		double delta_right = (right_pos - prev_right_pos) / tpi;
-		double delta_middle = configData.middleEncoderPort
-		                          ? (middle_pos - prev_middle_pos) / middle_tpi
-		                          : 0;
-
-		// calculate new heading
-		double delta_angle;
-		if (imu) {
-			heading = -imu->get_rotation() * M_PI / 180.0;
-			delta_angle = heading - prev_heading;
-		} else {
-			delta_angle = (delta_right - delta_left) / track_width;
+	if (still) {
+		// zero velocity update, any rotation while still is drift
+		if (!was_still)
+			s.drift = 0;
+		s.drift += raw_increment;
+		s.increment = 0;
+	} else {
+		// fold the drift of the still interval that just ended into the bias
+		if (was_still && window >= BIAS_WINDOW) {
+			double bias = fmax(-MAX_BIAS, fmin(MAX_BIAS, s.drift / window));
+			s.bias += (bias - s.bias) * BIAS_FILTER;
+		}
+		s.increment = (raw_increment - s.bias * dt) * s.scale;
+	}
+	s.valid = true;
+}
+
+// return the fused imu rotation in degrees, or PROS_ERR_F if no imu could be
+// read. encoder_angle is the heading change measured by the encoders, used to
+// break ties between two imus when has_encoder is set.
+double updateImu(double movement, double encoder_angle, bool has_encoder) {
+	uint32_t now = pros::millis();
+	uint32_t dt = now - prev_imu_time;
+	uint32_t window = prev_imu_time - still_time;
+	prev_imu_time = now;
+
+	bool was_still = still;
+	if (bias_correction) {
+		if (movement > STILL_DISTANCE)
+			move_time = now;
+		still = now - move_time >= STILL_TIME;
+		if (still && !was_still)
+			still_time = now;
+	}
+
+	double votes[MAX_IMUS + 1];
+	int vote_count = 0;
+	for (int i = 0; i < imu_count; i++) {
+		if (imus[i].faulted)
+			continue;
+		readImu(imus[i], was_still, window, dt);
+		if (imus[i].valid)
+			votes[vote_count++] = imus[i].increment;
+	}
+
+	// the median increment is the reference for fault detection, with the
+	// encoders as the deciding vote when there is an even number of imus.
+	// Without them two imus can not tell which one is wrong, so neither is
+	// dropped.
+	double encoder_increment = has_encoder ? -encoder_angle * 180 / M_PI : 0;
+	if (vote_count % 2 == 0 && has_encoder)
+		votes[vote_count++] = still ? 0 : encoder_increment;
+	double reference = vote_count ? median(votes, vote_count) : 0;
+	bool majority = vote_count >= 3;
+
+	// weighted average of the imus that agree with the reference
+	double sum = 0;
+	double weights = 0;
+	for (int i = 0; i < imu_count; i++) {
+		imu_state_s_t& s = imus[i];
+		if (s.faulted || !s.valid)
+			continue;
+		if (imu_count > 1) {
+			double residual = s.increment - reference;
+			s.error = s.error * FAULT_DECAY + residual;
+			if (majority && fabs(s.error) > FAULT_ERROR) {
+				s.faulted = true;
+				printf("ARMS WARNING: IMU %d diverged and was dropped\n", i);
+				continue;
+			}
+			s.noise += (residual * residual - s.noise) * NOISE_FILTER;
+		}
+		double weight = 1 / (s.noise + MIN_NOISE);
+		sum += s.increment * weight;
+		weights += weight;
+	}
+
+	if (weights == 0) {
+		// keep the rotation continuous until an imu comes back, or hold it if
+		// the encoders can not measure it
+		imu_rotation += still ? 0 : encoder_increment;
+		return PROS_ERR_F;
+	}
+	double increment = sum / weights;
+	imu_rotation += increment;
 
-			heading += delta_angle;
+	// least squares fit of each imu's scale to the fused rotation
+	if (imu_count > 1 && !still) {
+		for (int i = 0; i < imu_count; i++) {
+			imu_state_s_t& s = imus[i];
+			if (s.faulted || !s.valid)
+				continue;
+			double raw = s.increment / s.scale;
+			s.scale_num += increment * raw;
+			s.scale_den += raw * raw;
+			s.turned += fabs(raw);
+			if (s.turned > SCALE_ROTATION && s.scale_den > 0)
+				s.scale = fmax(1 - MAX_SCALE_ERROR,
+				               fmin(1 + MAX_SCALE_ERROR, s.scale_num / s.scale_den));
 		}
+	}
+
+	return imu_rotation;
+}
+
+void resetImu(double rotation) {
+	imu_rotation = rotation;
+	for (int i = 0; i < imu_count; i++) {
+		imus[i].imu->set_rotation(rotation);
+		imus[i].connected = false;
+		imus[i].faulted = false;
+		imus[i].error = 0;
+	}
+	prev_imu_time = pros::millis();
+	move_time = prev_imu_time;
+	still = false;
+}
+
+void correctGps() {
+	uint32_t now = pros::millis();
+	if (!gps || now - prev_gps_time < GPS_PERIOD)
+		return;
+	prev_gps_time = now;
+
+	double error = gps->get_error();
+	if (error == PROS_ERR_F || error > GPS_MAX_ERROR)
+		return;
+	pros::c::gps_status_s_t status = gps->get_status();
+	if (status.x == PROS_ERR_F)
+		return;
+
+	double deviation = fmax(error, GPS_MIN_ERROR) * METERS_TO_INCHES;
+	ekf.correctPosition(status.x * METERS_TO_INCHES, status.y * METERS_TO_INCHES,
+	                    deviation * deviation);
+}
+
+void track(tracker_s_t& t, double measurement, double dt) {
+	double predicted = t.value + t.rate * dt + t.accel * dt * dt / 2;
+	double residual = measurement - predicted;
+	t.value = predicted + TRACK_ALPHA * residual;
+	t.rate += t.accel * dt + TRACK_BETA * residual / dt;
+	t.accel += 2 * TRACK_GAMMA * residual / (dt * dt);
+}
+
+// update the velocity and acceleration with the field motion of this step
+void updateTwist(Point delta, double delta_angle) {
+	uint64_t now = pros::micros();
+	double dt = (now - prev_twist_time) / 1e6;
+	prev_twist_time = now;
+	if (dt <= 0 || dt > 0.1)
+		return; // first update, or the odometry stalled
+
+	motion[0] += delta.x;
+	motion[1] += delta.y;
+	motion[2] += delta_angle;
+	for (int i = 0; i < 3; i++)
+		track(trackers[i], motion[i], dt);
+
+	if (twistSource == TWIST_SENSOR) {
+		// rotation sensors report centidegrees per second, like tpi
+		double left = leftRotation->get_velocity() / tpi;
+		double right = rightRotation->get_velocity() / tpi;
+		double middle =
+		    middleRotation ? middleRotation->get_velocity() / middle_tpi : 0;
+		// without a track width the turn rate comes from the tracked heading,
+		// which follows the imu
+		double angular =
+		    track_width > 0 ? (right - left) / track_width : trackers[2].rate;
+		double forward = right - left_right_distance * angular;
+		double strafe = middle + middle_distance * angular;
+
+		Twist measured = {cos(heading) * forward - sin(heading) * strafe,
+		                  sin(heading) * forward + cos(heading) * strafe, angular};
+		acceleration.x +=
+		    ((measured.x - velocity.x) / dt - acceleration.x) * ACCEL_FILTER;
+		acceleration.y +=
+		    ((measured.y - velocity.y) / dt - acceleration.y) * ACCEL_FILTER;
+		acceleration.theta +=
+		    ((measured.theta - velocity.theta) / dt - acceleration.theta) *
+		    ACCEL_FILTER;
+		velocity = measured;
+	} else {
+		velocity = {trackers[0].rate, trackers[1].rate, trackers[2].rate};
+		acceleration = {trackers[0].accel, trackers[1].accel, trackers[2].accel};
+	}
+}
 
-		// store previous positions
-		prev_left_pos = left_pos;
-		prev_right_pos = right_pos;
-		prev_middle_pos = middle_pos;
-		prev_heading = heading;
+void publish() {
+	Pose pose = {position.x, position.y, heading, pros::millis()};
 
-		// calculate local displacement
-		double local_x;
-		double local_y;
+	uint32_t next = pose_index.load(std::memory_order_relaxed) ^ 1;
+	pose_buffer_s_t& buffer = pose_buffers[next];
 
-		if (delta_angle) {
-			double i = sin(delta_angle / 2.0) * 2.0;
-			local_x = (delta_right / delta_angle - left_right_distance) * i;
-			local_y = (delta_middle / delta_angle + middle_distance) * i;
+	// an odd sequence number marks the buffer as being written
+	buffer.seq.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	buffer.pose = pose;
+	buffer.velocity = velocity;
+	buffer.acceleration = acceleration;
+	std::atomic_thread_fence(std::memory_order_release);
+	buffer.seq.fetch_add(1, std::memory_order_relaxed);
+
+	pose_index.store(next, std::memory_order_release);
+
+	// record the pose in the history
+	uint32_t head = history_head.load(std::memory_order_relaxed);
+	history[head % HISTORY_SIZE] = pose;
+	history_head.store(head + 1, std::memory_order_release);
+}
+
+void clearHistory() {
+	history_start.store(history_head.load(std::memory_order_relaxed),
+	                    std::memory_order_release);
+}
+
+// read a consistent copy of the published buffer without blocking the writer
+void readBuffer(Pose* pose, Twist* velocity, Twist* acceleration) {
+	while (true) {
+		pose_buffer_s_t& buffer =
+		    pose_buffers[pose_index.load(std::memory_order_acquire)];
+		uint32_t seq = buffer.seq.load(std::memory_order_acquire);
+		*pose = buffer.pose;
+		*velocity = buffer.velocity;
+		*acceleration = buffer.acceleration;
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// retry if the writer got around to this buffer while we were reading
+		if (!(seq & 1) && buffer.seq.load(std::memory_order_relaxed) == seq)
+			return;
+	}
+}
+
+Pose getPose() {
+	Pose pose;
+	Twist velocity;
+	Twist acceleration;
+	readBuffer(&pose, &velocity, &acceleration);
+	return pose;
+}
+
+// rotate a field frame twist into the robot frame
+Twist toRobotFrame(Twist twist, double heading) {
+	return {cos(heading) * twist.x + sin(heading) * twist.y,
+	        -sin(heading) * twist.x + cos(heading) * twist.y, twist.theta};
+}
+
+Twist getVelocity(bool field) {
+	Pose pose;
+	Twist velocity;
+	Twist acceleration;
+	readBuffer(&pose, &velocity, &acceleration);
+	return field ? velocity : toRobotFrame(velocity, pose.theta);
+}
+
+Twist getAcceleration(bool field) {
+	Pose pose;
+	Twist velocity;
+	Twist acceleration;
+	readBuffer(&pose, &velocity, &acceleration);
+	return field ? acceleration : toRobotFrame(acceleration, pose.theta);
+}
+
+Pose getPositionAt(uint32_t time) {
+	while (true) {
+		uint32_t head = history_head.load(std::memory_order_acquire);
+		uint32_t start = history_start.load(std::memory_order_acquire);
+		if (head == start)
+			return getPose();
+
+		// skip the entries the writer is about to overwrite
+		uint32_t oldest = start;
+		if (head - start > HISTORY_SIZE - HISTORY_MARGIN)
+			oldest = head - (HISTORY_SIZE - HISTORY_MARGIN);
+
+		// find the first entry newer than the requested time
+		uint32_t low = oldest;
+		uint32_t high = head;
+		while (low < high) {
+			uint32_t mid = low + (high - low) / 2;
+			if ((int32_t)(history[mid % HISTORY_SIZE].time - time) > 0)
+				high = mid;
+			else
+				low = mid + 1;
+		}
+
+		Pose pose;
+		if (low == oldest) {
+			pose = history[oldest % HISTORY_SIZE];
+		} else if (low == head) {
+			pose = history[(head - 1) % HISTORY_SIZE];
 		} else {
-			local_x = delta_right;
-			local_y = delta_middle;
+			// interpolate between the samples on either side of the time
+			Pose a = history[(low - 1) % HISTORY_SIZE];
+			Pose b = history[low % HISTORY_SIZE];
+			double t = (double)(time - a.time) / (b.time - a.time);
+			pose = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+			        a.theta + (b.theta - a.theta) * t, time};
 		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// retry if the writer overwrote the entries while we were reading
+		if (history_head.load(std::memory_order_relaxed) - oldest < HISTORY_SIZE &&
+		    history_start.load(std::memory_order_relaxed) == start)
+			return pose;
+	}
+}
+
+void update() {
+	state_mutex.take();
+	double start_heading = heading;
+
+	// get positions of each encoder
+	double left_pos = getLeftEncoder();
+	double right_pos = getRightEncoder();
+	double middle_pos = configData.middleEncoderPort ? getMiddleEncoder() : 0;
+
+	// polling faster than the sensors publish mostly sees the last sample again
+	uint64_t now = pros::micros();
+	if (sensor_rate && left_pos == prev_left_pos &&
+	    right_pos == prev_right_pos && middle_pos == prev_middle_pos &&
+	    now - prev_update_time < SAMPLE_TIMEOUT * 1000) {
+		state_mutex.give();
+		return;
+	}
+	if (prev_update_time != 0) {
+		double dt = (now - prev_update_time) / 1000.0;
+		if (update_period == 0)
+			update_period = dt;
+		update_period += (dt - update_period) * RATE_FILTER;
+	}
+	prev_update_time = now;
+
+	// calculate change in each encoder
+	double delta_left = (left_pos - prev_left_pos) / tpi;
+	double delta_right = (right_pos - prev_right_pos) / tpi;
+	double delta_middle = configData.middleEncoderPort
+	                          ? (middle_pos - prev_middle_pos) / middle_tpi
+	                          : 0;
+
+	double movement = fabs(delta_left) + fabs(delta_right) + fabs(delta_middle);
+
+	// the encoders only measure the heading with a track width
+	bool encoder_heading = track_width > 0;
+	double encoder_angle =
+	    encoder_heading ? (delta_right - delta_left) / track_width : 0;
+	double rotation =
+	    imu ? updateImu(movement, encoder_angle, encoder_heading) : 0;
+
+	// calculate new heading
+	double delta_angle;
+	if (imu && !filter && rotation != PROS_ERR_F) {
+		heading = -rotation * M_PI / 180.0;
+		delta_angle = heading - prev_heading;
+	} else if (encoder_heading) {
+		delta_angle = encoder_angle;
+
+		heading += delta_angle;
+	} else if (imu && rotation != PROS_ERR_F) {
+		// without a track width only the imu measures the heading, so the pose
+		// filter predicts the turn from it
+		delta_angle = -rotation * M_PI / 180.0 - heading;
+		heading += delta_angle;
+	} else {
+		delta_angle = 0; // nothing measures the heading, hold it
+	}
+
+	// store previous positions
+	prev_left_pos = left_pos;
+	prev_right_pos = right_pos;
+	prev_middle_pos = middle_pos;
+	prev_heading = heading;
+
+	// distances travelled by the tracking center
+	double forward = delta_right - left_right_distance * delta_angle;
+	double left = delta_middle + middle_distance * delta_angle;
+
+	// convert to absolute displacement
+	Point delta =
+	    integrate(integrator, forward, left, delta_angle, heading - delta_angle);
 
-		double p = heading - delta_angle / 2.0; // global angle
+	if (filter) {
+		// the encoders predict the motion, the imu and gps correct it
+		ekf.predict(delta, forward, left, delta_angle);
+		if (imu && rotation != PROS_ERR_F)
+			ekf.correctHeading(-rotation * M_PI / 180.0, IMU_VARIANCE);
+		correctGps();
 
-		// convert to absolute displacement
-		position.x += cos(p) * local_x - sin(p) * local_y;
-		position.y += cos(p) * local_y + sin(p) * local_x;
+		position.x = ekf.x;
+		position.y = ekf.y;
+		heading = ekf.theta;
+	} else {
+		position.x += delta.x;
+		position.y += delta.y;
+	}
+
+	updateTwist(delta, heading - start_heading);
 
-		if (debug)
-			printf("%.2f, %.2f, %.2f \n", position.x, position.y, getHeading());
+	publish();
+	state_mutex.give();
 
-		pros::delay(10);
+	if (debug) {
+		Pose pose = getPose();
+		printf("%.2f, %.2f, %.2f \n", pose.x, pose.y, pose.theta * 180 / M_PI);
+	}
+}
+
+int odomTask() {
+	while (true) {
+		update();
+		scheduler.wait();
 	}
 }
 
 void reset(Point point) {
+	state_mutex.take();
 	position.x = point.x;
 	position.y = point.y;
+	ekf.reset(position.x, position.y, heading);
+	clearHistory();
+	publish();
+	state_mutex.give();
 	desired_pos.x = point.x;
 	desired_pos.y = point.y;
 }
 
 void reset(Point point, double angle) {
-	reset(point);
+	state_mutex.take();
+	position.x = point.x;
+	position.y = point.y;
 	heading = angle * M_PI / 180.0;
 	prev_heading = heading;
-	desired_heading = heading;
 	if (imu)
-		imu->set_rotation(-angle);
+		resetImu(-angle);
+	ekf.reset(position.x, position.y, heading);
+	clearHistory();
+	publish();
+	state_mutex.give();
+	desired_pos.x = point.x;
+	desired_pos.y = point.y;
+	desired_heading = angle * M_PI / 180.0;
+}
+
+Pose correct(Point point, uint32_t time, double variance) {
+	// the odometry has moved on since the reading, so apply the error at that
+	// time to the current position
+	Pose past = getPositionAt(time);
+	double dx = point.x - past.x;
+	double dy = point.y - past.y;
+
+	state_mutex.take();
+	Pose prev = {position.x, position.y, heading, pros::millis()};
+	if (filter) {
+		ekf.correctPosition(position.x + dx, position.y + dy, variance);
+		position.x = ekf.x;
+		position.y = ekf.y;
+		heading = ekf.theta;
+	} else {
+		position.x += dx * CORRECTION_GAIN;
+		position.y += dy * CORRECTION_GAIN;
+	}
+	publish();
+	Pose shift = {position.x - prev.x, position.y - prev.y, heading - prev.theta,
+	              prev.time};
+	state_mutex.give();
+	return shift;
+}
+
+tracking_s_t getTracking() {
+	state_mutex.take();
+	tracking_s_t tracking = {tpi, middle_tpi, track_width, middle_distance};
+	state_mutex.give();
+	return tracking;
+}
+
+void setTracking(tracking_s_t tracking) {
+	state_mutex.take();
+	tpi = tracking.tpi;
+	middle_tpi = tracking.middle_tpi;
+	track_width = tracking.track_width;
+	left_right_distance = tracking.track_width / 2;
+	middle_distance = tracking.middle_distance;
+	state_mutex.give();
 }
 
 Point getPosition() {
-	return position;
+	Pose pose = getPose();
+	return {pose.x, pose.y};
 }
 
 Point getDesiredPosition() {
@@ -164,9 +817,10 @@ void setDesiredHeading(double angle) {
 }
 
 double getHeading(bool radians) {
+	Pose pose = getPose();
 	if (radians)
-		return heading;
-	return heading * 180 / M_PI;
+		return pose.theta;
+	return pose.theta * 180 / M_PI;
 }
 
 double getDesiredHeading(bool radians) {
@@ -176,18 +830,19 @@ double getDesiredHeading(bool radians) {
 }
 
 double getAngleError(Point point) {
+	Pose pose = getPose();
 	double x = point.x;
 	double y = point.y;
 
-	x -= position.x;
-	y -= position.y;
+	x -= pose.x;
+	y -= pose.y;
 
-	double delta_theta = atan2(y, x) - heading;
+	double delta_theta = atan2(y, x) - pose.theta;
 
 	// if movement is reversed, calculate delta_theta using a 180 degree rotation
 	// of the target point
 	if (pid::reverse) {
-		delta_theta = atan2(-y, -x) - heading;
+		delta_theta = atan2(-y, -x) - pose.theta;
 	}
 
 	while (fabs(delta_theta) > M_PI) {
@@ -198,26 +853,103 @@ double getAngleError(Point point) {
 }
 
 double getDistanceError(Point point) {
+	Pose pose = getPose();
 	double x = point.x;
 	double y = point.y;
 
-	y -= position.y;
-	x -= position.x;
+	y -= pose.y;
+	x -= pose.x;
 	return sqrt(x * x + y * y);
 }
 
+loop_stats_s_t getLoopStats() {
+	if (fused)
+		return chassis::getLoopStats();
+	return scheduler.getStats();
+}
+
+void resetLoopStats() {
+	if (fused)
+		chassis::resetLoopStats();
+	else
+		scheduler.resetStats();
+}
+
+std::array<double, 3> getUncertainty() {
+	state_mutex.take();
+	double P[3] = {ekf.P[0][0], ekf.P[1][1], ekf.P[2][2]};
+	state_mutex.give();
+	return {sqrt(fmax(P[0], 0)), sqrt(fmax(P[1], 0)),
+	        sqrt(fmax(P[2], 0)) * 180 / M_PI};
+}
+
+double getGyroBias(int sensor) {
+	if (sensor < 0 || sensor >= imu_count)
+		return 0;
+	return imus[sensor].bias * 1000;
+}
+
+double getImuScale(int sensor) {
+	if (sensor < 0 || sensor >= imu_count)
+		return 1;
+	return imus[sensor].scale;
+}
+
+bool isImuFaulted(int sensor) {
+	if (sensor < 0 || sensor >= imu_count)
+		return false;
+	return imus[sensor].faulted;
+}
+
+uint32_t getRejectedReadings() {
+	return ekf.rejected;
+}
+
+double getUpdateRate() {
+	state_mutex.take();
+	double period = update_period;
+	state_mutex.give();
+	return period > 0 ? 1000.0 / period : 0;
+}
+
 void init(bool debug, EncoderType_e_t encoderType,
           std::array<int, 3> encoderPorts, int expanderPort, int imuPort,
           double track_width, double middle_distance, double tpi,
-          double middle_tpi) {
+          double middle_tpi, int period, bool fused, bool sensor_rate,
+          MotorEncoderMode_e_t motorEncoderMode, Integrator_e_t integrator,
+          bool filter, int gpsPort, std::array<double, 2> gpsOffset,
+          bool bias_correction, std::initializer_list<int> extraImuPorts,
+          TwistSource_e_t twistSource) {
 	odom::debug = debug;
 	odom::track_width = track_width;
 	odom::left_right_distance = track_width / 2;
 	odom::middle_distance = middle_distance;
 	odom::tpi = tpi;
 	odom::middle_tpi = middle_tpi;
+	odom::motorEncoderMode = motorEncoderMode;
+	odom::integrator = integrator;
+	odom::filter = filter;
+	odom::bias_correction = bias_correction;
+	odom::twistSource = twistSource;
+	if (twistSource == TWIST_SENSOR &&
+	    (encoderType != ENCODER_ROTATION || encoderPorts[0] == 0)) {
+		odom::twistSource = TWIST_DIFFERENTIATOR;
+		printf("ARMS WARNING: sensor velocities require rotation sensors\n");
+	}
+	scheduler.setPeriod(period);
+
+	// sensor rate odometry needs rotation sensors, the adi and motor encoders
+	// only update every 10ms
+	odom::sensor_rate = sensor_rate && encoderType == ENCODER_ROTATION &&
+	                    encoderPorts[0] != 0 && !fused;
+	if (odom::sensor_rate)
+		scheduler.setPeriod(SENSOR_DATA_RATE);
+	else if (sensor_rate)
+		printf("ARMS WARNING: sensor rate odometry requires rotation sensors and "
+		       "no fused control\n");
 
-	pros::Task odom_task(odomTask);
+	if (!fused)
+		pros::Task odom_task(odomTask);
 
 	configData.expanderPort = expanderPort;
 	configData.leftEncoderPort = encoderPorts[0];
@@ -281,16 +1013,48 @@ void init(bool debug, EncoderType_e_t encoderType,
 	default:
 		break;
 	}
-	// initialize imu
-	if (imuPort != 0) {
-		imu = std::make_shared<pros::Imu>(imuPort);
-		int rtn = imu->reset(true);
+	// initialize imus, calibrating them all at once
+	imu_count = 0;
+	if (imuPort != 0)
+		imus[imu_count++].imu = std::make_shared<pros::Imu>(imuPort);
+	for (int port : extraImuPorts)
+		if (port != 0 && imu_count < MAX_IMUS)
+			imus[imu_count++].imu = std::make_shared<pros::Imu>(port);
+	if (imu_count > 0)
+		imu = imus[0].imu;
+	for (int i = 0; i < imu_count; i++) {
+		int rtn = imus[i].imu->reset();
 		if (rtn != 1) {
 			printf("ARMS ERROR: IMU reset failed with error code %d", errno);
 		}
 	}
+	for (int i = 0; i < imu_count; i++)
+		while (imus[i].imu->is_calibrating())
+			pros::delay(10);
+
+	// initialize gps, the offset is right and forward of the tracking center in
+	// meters
+	if (gpsPort != 0) {
+		gps = std::make_shared<pros::Gps>(gpsPort, -gpsOffset[1] / METERS_TO_INCHES,
+		                                  gpsOffset[0] / METERS_TO_INCHES);
+		if (!filter)
+			printf("ARMS WARNING: the gps is only used by the pose filter\n");
+	}
+
+	// publish sensor data at the rate the odometry integrates it
+	if (odom::sensor_rate) {
+		leftRotation->set_data_rate(SENSOR_DATA_RATE);
+		rightRotation->set_data_rate(SENSOR_DATA_RATE);
+		if (middleRotation)
+			middleRotation->set_data_rate(SENSOR_DATA_RATE);
+		for (int i = 0; i < imu_count; i++)
+			imus[i].imu->set_data_rate(SENSOR_DATA_RATE);
+	}
 	pros::delay(100);
 	reset();
+
+	// hand the odometry updates to the chassis task once the sensors are ready
+	odom::fused = fused;
 }
 
 } // namespace arms::odom
@@ -0,0 +1,82 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms {
+
+// resample the segments evenly in arc length
+std::vector<path_sample_s_t>
+tabulate(const std::vector<bake::segment_s_t>& segments, double spacing) {
+	double total = bake::measure(segments.data(), segments.size());
+	int count = floor(total / spacing) + 1;
+	if ((count - 1) * spacing < total - 1e-9)
+		count++; // the end falls between entries
+
+	std::vector<path_sample_s_t> table(count);
+	bake::tabulate(segments.data(), segments.size(), spacing, table.data(),
+	               count);
+	return table;
+}
+
+Path::Path() : spacing(1) {
+}
+
+Path::Path(SplineType_e_t type, std::vector<waypoint_s_t> waypoints,
+           double spacing)
+    : spacing(spacing) {
+	if (waypoints.size() < 2 || spacing <= 0) {
+		printf("ARMS ERROR: a spline needs two waypoints and a positive "
+		       "spacing\n");
+		return;
+	}
+
+	std::vector<bake::segment_s_t> segments;
+	for (size_t i = 0; i + 1 < waypoints.size(); i++)
+		segments.push_back(bake::hermite(type, waypoints[i], waypoints[i + 1]));
+	table = tabulate(segments, spacing);
+}
+
+Path::Path(std::vector<Point> control, double spacing) : spacing(spacing) {
+	if (control.size() < 4 || (control.size() - 1) % 3 != 0 || spacing <= 0) {
+		printf("ARMS ERROR: a bezier path needs 3n + 1 control points and a "
+		       "positive spacing\n");
+		return;
+	}
+
+	std::vector<bake::segment_s_t> segments;
+	for (size_t i = 0; i + 3 < control.size(); i += 3)
+		segments.push_back(bake::bezier(control[i], control[i + 1], control[i + 2],
+		                                control[i + 3]));
+	table = tabulate(segments, spacing);
+}
+
+path_sample_s_t Path::sample(double distance) const {
+	if (table.empty())
+		return {0, 0, 0, 0, 0};
+	if (distance <= 0)
+		return table.front();
+	if (distance >= table.back().distance)
+		return table.back();
+
+	// entries are evenly spaced, only the last gap can be shorter
+	int i = std::min((int)(distance / spacing), (int)table.size() - 2);
+	const path_sample_s_t& a = table[i];
+	const path_sample_s_t& b = table[i + 1];
+	double s = (distance - a.distance) / (b.distance - a.distance);
+	return {distance, a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s,
+	        a.theta + (b.theta - a.theta) * s,
+	        a.curvature + (b.curvature - a.curvature) * s};
+}
+
+double Path::getLength() const {
+	return table.empty() ? 0 : table.back().distance;
+}
+
+const path_sample_s_t* Path::data() const {
+	return table.data();
+}
+
+int Path::size() const {
+	return table.size();
+}
+
+} // namespace arms
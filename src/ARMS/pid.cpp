@@ -36,6 +36,13 @@ Point pointTarget{0, 0};
 
 bool canReverse;
 
+// motion profile
+bool profiled = false;
+Profile profile;
+uint32_t profile_start;
+Point profile_origin;
+double profile_heading; // radians, line of a move or start of a turn
+
 double pid(double error, double* pe, double* in, double kp, double ki,
            double kd) {
 
@@ -60,7 +67,76 @@ double pid(double target, double sv, double* pe, double* in, double kp,
 	return pid(error, pe, in, kp, ki, kd);
 }
 
+void startProfile(Profile profile, double heading) {
+	odom::Pose pose = odom::getPose();
+	pid::profile = profile;
+	profile_start = pros::millis();
+	profile_origin = {pose.x, pose.y};
+	profile_heading = heading;
+	profiled = true;
+}
+
+bool profileDone() {
+	return (pros::millis() - profile_start) / 1000.0 >= profile.getDuration();
+}
+
+profile_point_s_t profileSetpoint() {
+	return profile.sample((pros::millis() - profile_start) / 1000.0);
+}
+
+// track the position setpoint along the line while holding the heading, the
+// chassis adds the profile velocity as feedforward
+std::array<double, 2> followLine() {
+	static double pe_lin = 0;
+	static double pe_ang = 0;
+
+	if (linearKP == -1)
+		linearKP = defaultLinearKP;
+	if (trackingKP == -1)
+		trackingKP = defaultTrackingKP;
+
+	profile_point_s_t setpoint = profileSetpoint();
+	chassis::setReference({setpoint.velocity, setpoint.velocity},
+	                      {setpoint.acceleration, setpoint.acceleration});
+
+	odom::Pose pose = odom::getPose();
+	double progress = (pose.x - profile_origin.x) * cos(profile_heading) +
+	                  (pose.y - profile_origin.y) * sin(profile_heading);
+	double lin_speed = pid(setpoint.position - progress, &pe_lin, &in_lin,
+	                       linearKP, linearKI, linearKD);
+
+	double ang_error = profile_heading - pose.theta;
+	while (fabs(ang_error) > M_PI)
+		ang_error -= 2 * M_PI * ang_error / fabs(ang_error);
+	double ang_speed = pid(ang_error, &pe_ang, &in_ang, trackingKP, 0, 0);
+
+	return {lin_speed - ang_speed, lin_speed + ang_speed};
+}
+
+// track the heading setpoint, the wheel velocities of the turn go to the
+// feedforward
+std::array<double, 2> followTurn() {
+	static double pe = 0;
+
+	if (angularKP == -1)
+		angularKP = defaultAngularKP;
+
+	profile_point_s_t setpoint = profileSetpoint();
+	double inches_per_degree = chassis::getDriveWidth() / 2 * M_PI / 180;
+	double velocity = setpoint.velocity * inches_per_degree;
+	double acceleration = setpoint.acceleration * inches_per_degree;
+	chassis::setReference({-velocity, velocity}, {-acceleration, acceleration});
+
+	double target = profile_heading * 180 / M_PI + setpoint.position;
+	double speed = pid(target, odom::getHeading(), &pe, &in_ang, angularKP,
+	                   angularKI, angularKD);
+	return {-speed, speed};
+}
+
 std::array<double, 2> translational() {
+	if (profiled)
+		return followLine();
+
 	// previous sensor values
 	static double pe_lin = 0;
 	static double pe_ang = 0;
@@ -155,7 +231,62 @@ std::array<double, 2> translational() {
 	return {left_speed, right_speed};
 }
 
+std::array<double, 3> holonomic() {
+	// previous sensor values
+	static double pe_lin = 0;
+	static double pe_ang = 0;
+
+	// check for default kp
+	if (linearKP == -1)
+		linearKP = defaultLinearKP;
+	if (trackingKP == -1)
+		trackingKP = defaultTrackingKP;
+
+	odom::Pose pose = odom::getPose();
+	double dx = pointTarget.x - pose.x;
+	double dy = pointTarget.y - pose.y;
+	double lin_error = sqrt(dx * dx + dy * dy);
+
+	// calculate linear speed
+	double lin_speed;
+	if (thru)
+		lin_speed = chassis::maxSpeed; // disable PID for thru movement
+	else
+		lin_speed = pid(lin_error, &pe_lin, &in_lin, linearKP, linearKI, linearKD);
+
+	// cap linear speed
+	if (lin_speed > chassis::maxSpeed)
+		lin_speed = chassis::maxSpeed;
+
+	if (lin_speed < chassis::min_linear_speed)
+		lin_speed = chassis::min_linear_speed;
+
+	// drive straight at the target in the robot frame
+	double forward = 0;
+	double left = 0;
+	if (lin_error > 0) {
+		double c = cos(pose.theta);
+		double s = sin(pose.theta);
+		forward = (dx * c + dy * s) / lin_error * lin_speed;
+		left = (-dx * s + dy * c) / lin_error * lin_speed;
+	}
+
+	// turn to the final pose angle during the movement, or hold the heading for
+	// a point movement
+	double target = angularTarget > 360 ? odom::getDesiredHeading(true)
+	                                    : angularTarget * M_PI / 180;
+	double ang_error = target - pose.theta;
+	while (fabs(ang_error) > M_PI)
+		ang_error -= 2 * M_PI * ang_error / fabs(ang_error);
+	double ang_speed = pid(ang_error, &pe_ang, &in_ang, trackingKP, 0, 0);
+
+	return {forward, left, ang_speed};
+}
+
 std::array<double, 2> angular() {
+	if (profiled)
+		return followTurn();
+
 	static double pe = 0; // previous error
 
 	if (angularKP == -1)
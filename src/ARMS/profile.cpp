@@ -0,0 +1,123 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms {
+
+// iterations of the search for the peak velocity of a short profile
+#define PEAK_ITERATIONS 40
+
+// distance covered speeding up from rest to a velocity, also returns the
+// length of the jerk and constant acceleration segments
+double rampDistance(ProfileType_e_t type, double velocity, double acceleration,
+                    double jerk, double* t_jerk, double* t_accel) {
+	if (type == PROFILE_S_CURVE && jerk > 0) {
+		if (velocity * jerk >= acceleration * acceleration) {
+			*t_jerk = acceleration / jerk;
+			*t_accel = velocity / acceleration - *t_jerk;
+		} else {
+			// the acceleration limit is never reached
+			*t_jerk = sqrt(velocity / jerk);
+			*t_accel = 0;
+		}
+	} else {
+		*t_jerk = 0;
+		*t_accel = velocity / acceleration;
+	}
+
+	// the velocity curve is symmetric, so the average velocity is half the peak
+	return velocity * (*t_accel + 2 * *t_jerk) / 2;
+}
+
+Profile::Profile() : Profile(PROFILE_NONE, 0, 0, 0) {
+}
+
+Profile::Profile(ProfileType_e_t type, double distance, double max_velocity,
+                 double max_acceleration, double max_jerk) {
+	direction = distance < 0 ? -1 : 1;
+	distance = fabs(distance);
+	end = {distance, 0, 0};
+	for (int i = 0; i < 8; i++)
+		times[i] = 0;
+	for (int i = 0; i < 7; i++) {
+		jerk[i] = 0;
+		starts[i] = {0, 0, 0};
+	}
+	if (type == PROFILE_NONE || distance == 0 || max_velocity <= 0 ||
+	    max_acceleration <= 0)
+		return;
+
+	double velocity = max_velocity;
+	double t_jerk;
+	double t_accel;
+	double ramp = rampDistance(type, velocity, max_acceleration, max_jerk,
+	                           &t_jerk, &t_accel);
+
+	// too short to reach full speed, find the peak velocity that just fits
+	if (2 * ramp > distance) {
+		double low = 0;
+		double high = max_velocity;
+		for (int i = 0; i < PEAK_ITERATIONS; i++) {
+			double mid = (low + high) / 2;
+			if (2 * rampDistance(type, mid, max_acceleration, max_jerk, &t_jerk,
+			                     &t_accel) > distance)
+				high = mid;
+			else
+				low = mid;
+		}
+		velocity = low;
+		ramp = rampDistance(type, velocity, max_acceleration, max_jerk, &t_jerk,
+		                    &t_accel);
+	}
+	if (velocity <= 0)
+		return;
+
+	double t_cruise = (distance - 2 * ramp) / velocity;
+	double peak = t_jerk > 0 ? max_jerk * t_jerk : max_acceleration;
+	double j = t_jerk > 0 ? max_jerk : 0;
+
+	double durations[7] = {t_jerk, t_accel, t_jerk, t_cruise,
+	                       t_jerk, t_accel, t_jerk};
+	double jerks[7] = {j, 0, -j, 0, -j, 0, j};
+	double accelerations[7] = {0, peak, peak, 0, 0, -peak, -peak};
+
+	// integrate the segments to find the setpoint at the start of each
+	double p = 0;
+	double v = 0;
+	double t = 0;
+	for (int i = 0; i < 7; i++) {
+		double T = durations[i];
+		double a = accelerations[i];
+		times[i] = t;
+		jerk[i] = jerks[i];
+		starts[i] = {p, v, a};
+		p += v * T + a * T * T / 2 + jerks[i] * T * T * T / 6;
+		v += a * T + jerks[i] * T * T / 2;
+		t += T;
+	}
+	times[7] = t;
+}
+
+profile_point_s_t Profile::sample(double t) {
+	if (t >= times[7])
+		return {direction * end.position, 0, 0};
+	if (t <= 0)
+		return {0, 0, 0};
+
+	int i = 6;
+	while (i > 0 && t < times[i])
+		i--;
+
+	double dt = t - times[i];
+	profile_point_s_t& s = starts[i];
+	double p = s.position + s.velocity * dt + s.acceleration * dt * dt / 2 +
+	           jerk[i] * dt * dt * dt / 6;
+	double v = s.velocity + s.acceleration * dt + jerk[i] * dt * dt / 2;
+	double a = s.acceleration + jerk[i] * dt;
+	return {direction * p, direction * v, direction * a};
+}
+
+double Profile::getDuration() {
+	return times[7];
+}
+
+} // namespace arms
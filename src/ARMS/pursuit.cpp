@@ -0,0 +1,391 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms::pursuit {
+
+#define MAX_PATH_POINTS 512
+
+// smoothing stops once a pass moves the points less than this in total
+#define SMOOTH_TOLERANCE 0.001
+#define MAX_SMOOTH_ITERATIONS 1000
+
+// percent speed that keeps the robot moving up to the end of the path
+#define MIN_SPEED 5
+
+// tuning
+double min_lookahead = 8;
+double max_lookahead = 16;
+double spacing = 2;
+double smoothing = 0.75;
+double turn_rate = 3;
+double acceleration = 60;
+
+// path being generated, preallocated so neither copy touches the heap
+path_point_s_t generated[MAX_PATH_POINTS];
+double original[MAX_PATH_POINTS][2];
+
+// path being followed, shared with the chassis task
+path_point_s_t path[MAX_PATH_POINTS];
+int size = 0;
+bool reverse = false;
+pros::Mutex path_mutex;
+
+// follower state
+int closest = 0;
+double lookahead_index = 0; // fractional index along the path
+Point lookahead{0, 0};
+double velocity = 0;
+uint32_t prev_time = 0;
+bool finished = false;
+
+// place points every spacing inches along each segment between waypoints
+int inject(std::vector<Point>& waypoints) {
+	int count = 0;
+	for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+		Point a = waypoints[i];
+		Point b = waypoints[i + 1];
+		double length =
+		    sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+		if (length == 0)
+			continue;
+
+		int steps = ceil(length / spacing);
+		for (int j = 0; j < steps; j++) {
+			if (count >= MAX_PATH_POINTS - 1)
+				return -1;
+			double t = (double)j / steps;
+			generated[count++] = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0, 0,
+			                      0};
+		}
+	}
+	Point end = waypoints.back();
+	generated[count++] = {end.x, end.y, 0, 0, 0};
+	return count;
+}
+
+// pull each point towards its neighbours while holding it near where it was
+// injected, the end points stay fixed
+void smooth(int count) {
+	double weight_data = 1 - smoothing;
+	for (int i = 0; i < count; i++) {
+		original[i][0] = generated[i].x;
+		original[i][1] = generated[i].y;
+	}
+
+	double change = SMOOTH_TOLERANCE;
+	for (int n = 0; n < MAX_SMOOTH_ITERATIONS && change >= SMOOTH_TOLERANCE;
+	     n++) {
+		change = 0;
+		for (int i = 1; i < count - 1; i++) {
+			double* p[2] = {&generated[i].x, &generated[i].y};
+			double prev[2] = {generated[i - 1].x, generated[i - 1].y};
+			double next[2] = {generated[i + 1].x, generated[i + 1].y};
+			for (int d = 0; d < 2; d++) {
+				double before = *p[d];
+				*p[d] += weight_data * (original[i][d] - *p[d]) +
+				         smoothing * (prev[d] + next[d] - 2 * *p[d]);
+				change += fabs(before - *p[d]);
+			}
+		}
+	}
+}
+
+// distance along the path and signed curvature through each point and its
+// neighbours
+void measure(int count) {
+	generated[0].distance = 0;
+	for (int i = 1; i < count; i++) {
+		double dx = generated[i].x - generated[i - 1].x;
+		double dy = generated[i].y - generated[i - 1].y;
+		generated[i].distance =
+		    generated[i - 1].distance + sqrt(dx * dx + dy * dy);
+	}
+
+	for (int i = 0; i < count; i++) {
+		generated[i].curvature = 0;
+		if (i == 0 || i == count - 1)
+			continue;
+		path_point_s_t& a = generated[i - 1];
+		path_point_s_t& b = generated[i];
+		path_point_s_t& c = generated[i + 1];
+		double cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		double ab = b.distance - a.distance;
+		double bc = c.distance - b.distance;
+		double ac = sqrt((c.x - a.x) * (c.x - a.x) + (c.y - a.y) * (c.y - a.y));
+		if (ab * bc * ac > 0)
+			generated[i].curvature = 2 * cross / (ab * bc * ac);
+	}
+}
+
+// target velocity of each point, a timed trajectory also has to start from
+// rest while the follower does this itself as it goes
+void plan(int count, double max_velocity, bool from_rest) {
+	bake::plan(generated, count, max_velocity, turn_rate, acceleration,
+	           from_rest);
+}
+
+// generate the path into the scratch buffer, returns the number of points
+int build(std::vector<Point>& waypoints, double max_velocity, bool from_rest) {
+	int count = waypoints.empty() ? -1 : inject(waypoints);
+	if (count < 0) {
+		printf("ARMS ERROR: path is empty or longer than %d points\n",
+		       MAX_PATH_POINTS);
+		return -1;
+	}
+	smooth(count);
+	measure(count);
+	plan(count, max_velocity, from_rest);
+	return count;
+}
+
+// copy a spline path into the scratch buffer, it already knows its distance
+// and curvature
+int build(const Path& path, double max_velocity, bool from_rest) {
+	int count = path.size();
+	if (count == 0 || count > MAX_PATH_POINTS) {
+		printf("ARMS ERROR: path is empty or longer than %d points\n",
+		       MAX_PATH_POINTS);
+		return -1;
+	}
+	const path_sample_s_t* samples = path.data();
+	for (int i = 0; i < count; i++)
+		generated[i] = {samples[i].x, samples[i].y, samples[i].distance,
+		                samples[i].curvature, 0};
+	plan(count, max_velocity, from_rest);
+	return count;
+}
+
+// copy the scratch buffer out
+int output(int count, path_point_s_t* out, int capacity) {
+	if (count > capacity) {
+		printf("ARMS ERROR: path does not fit in %d points\n", capacity);
+		return -1;
+	}
+	for (int i = 0; i < count; i++)
+		out[i] = generated[i];
+	return count;
+}
+
+int generate(std::vector<Point> waypoints, double max_velocity,
+             path_point_s_t* out, int capacity) {
+	return output(build(waypoints, max_velocity, true), out, capacity);
+}
+
+int generate(const Path& path, double max_velocity, path_point_s_t* out,
+             int capacity) {
+	return output(build(path, max_velocity, true), out, capacity);
+}
+
+// start following the scratch buffer
+bool follow(int count, bool reverse) {
+	if (count < 0)
+		return false;
+
+	path_mutex.take();
+	for (int i = 0; i < count; i++)
+		path[i] = generated[i];
+	size = count;
+	pursuit::reverse = reverse;
+	closest = 0;
+	lookahead_index = 0;
+	lookahead = {path[0].x, path[0].y};
+	velocity = 0;
+	prev_time = pros::millis();
+	finished = false;
+	path_mutex.give();
+	return true;
+}
+
+bool start(std::vector<Point> waypoints, double max_velocity, bool reverse) {
+	if (waypoints.empty())
+		return false;
+
+	// the path starts from where the robot is
+	waypoints.insert(waypoints.begin(), odom::getPosition());
+	return follow(build(waypoints, max_velocity, false), reverse);
+}
+
+bool start(const Path& path, double max_velocity, bool reverse) {
+	return follow(build(path, max_velocity, false), reverse);
+}
+
+// index of the path point nearest the robot, only searching ahead of the last
+// one so a path that crosses itself is followed in order
+void updateClosest(Point pos) {
+	double best = -1;
+	double horizon = path[closest].distance + 2 * max_lookahead;
+	for (int i = closest; i < size && path[i].distance <= horizon; i++) {
+		double dx = path[i].x - pos.x;
+		double dy = path[i].y - pos.y;
+		double d = dx * dx + dy * dy;
+		if (best < 0 || d < best) {
+			best = d;
+			closest = i;
+		}
+	}
+}
+
+// first intersection of the lookahead circle with the path beyond the last
+// lookahead point
+void updateLookahead(Point pos, double radius) {
+	Point end = {path[size - 1].x, path[size - 1].y};
+	double to_end = sqrt((end.x - pos.x) * (end.x - pos.x) +
+	                     (end.y - pos.y) * (end.y - pos.y));
+	if (to_end <= radius) {
+		lookahead_index = size - 1;
+		lookahead = end;
+		return;
+	}
+
+	double horizon = path[closest].distance + 2 * max_lookahead;
+	for (int i = (int)lookahead_index; i < size - 1; i++) {
+		if (path[i].distance > horizon)
+			break;
+		double dx = path[i + 1].x - path[i].x;
+		double dy = path[i + 1].y - path[i].y;
+		double fx = path[i].x - pos.x;
+		double fy = path[i].y - pos.y;
+		double a = dx * dx + dy * dy;
+		double b = 2 * (fx * dx + fy * dy);
+		double c = fx * fx + fy * fy - radius * radius;
+		double discriminant = b * b - 4 * a * c;
+		if (a == 0 || discriminant < 0)
+			continue;
+
+		// the far intersection is the one ahead of the robot
+		double root = sqrt(discriminant);
+		double ts[2] = {(-b + root) / (2 * a), (-b - root) / (2 * a)};
+		for (double t : ts) {
+			if (t >= 0 && t <= 1 && i + t > lookahead_index) {
+				lookahead_index = i + t;
+				lookahead = {path[i].x + t * dx, path[i].y + t * dy};
+				return;
+			}
+		}
+	}
+	// no intersection, keep steering at the last lookahead point
+}
+
+// true once the robot is on the last segment and beyond its end
+bool pastEnd(odom::Pose pose) {
+	if (size < 2 || closest < size - 2)
+		return false;
+	path_point_s_t& end = path[size - 1];
+	path_point_s_t& before = path[size - 2];
+	return (pose.x - end.x) * (end.x - before.x) +
+	           (pose.y - end.y) * (end.y - before.y) >=
+	       0;
+}
+
+void update() {
+	path_mutex.take();
+	if (size == 0 || finished) {
+		chassis::setReference({0, 0}, {0, 0});
+		path_mutex.give();
+		return;
+	}
+
+	uint32_t now = pros::millis();
+	double dt = (now - prev_time) / 1000.0;
+	prev_time = now;
+
+	odom::Pose pose = odom::getPose();
+	Point pos = {pose.x, pose.y};
+	double heading = reverse ? pose.theta + M_PI : pose.theta;
+
+	updateClosest(pos);
+
+	// limit the change in velocity, the path targets only plan the braking
+	double max_velocity = chassis::maxSpeed * chassis::getMaxVelocity() / 100;
+	double min_velocity = fmax(MIN_SPEED, chassis::min_linear_speed) *
+	                      chassis::getMaxVelocity() / 100;
+	double target =
+	    fmin(max_velocity, fmax(min_velocity, path[closest].velocity));
+	double step = acceleration * dt;
+	double accel = 0;
+	if (target > velocity + step) {
+		velocity += step;
+		accel = acceleration;
+	} else if (target < velocity - step) {
+		velocity -= step;
+		accel = -acceleration;
+	} else {
+		velocity = target;
+	}
+
+	// the lookahead grows with speed, looking further ahead on straights
+	double radius =
+	    min_lookahead + (max_lookahead - min_lookahead) *
+	                        fmin(1, velocity / chassis::getMaxVelocity());
+	updateLookahead(pos, radius);
+
+	// curvature of the arc from the robot through the lookahead point
+	double dx = lookahead.x - pos.x;
+	double dy = lookahead.y - pos.y;
+	double left = -sin(heading) * dx + cos(heading) * dy;
+	double distance_sq = dx * dx + dy * dy;
+	double curvature = distance_sq > 0 ? 2 * left / distance_sq : 0;
+
+	// wheel velocities, driving backwards swaps and negates the sides
+	double half_width = chassis::getDriveWidth() / 2;
+	double left_scale = 1 - curvature * half_width;
+	double right_scale = 1 + curvature * half_width;
+	if (reverse)
+		chassis::setReference({-velocity * right_scale, -velocity * left_scale},
+		                      {-accel * right_scale, -accel * left_scale});
+	else
+		chassis::setReference({velocity * left_scale, velocity * right_scale},
+		                      {accel * left_scale, accel * right_scale});
+
+	if (pastEnd(pose))
+		finished = true;
+	path_mutex.give();
+}
+
+bool done(double exit_error) {
+	path_mutex.take();
+	if (size == 0) {
+		path_mutex.give();
+		return true;
+	}
+
+	odom::Pose pose = odom::getPose();
+	double dx = pose.x - path[size - 1].x;
+	double dy = pose.y - path[size - 1].y;
+	if (pastEnd(pose) || sqrt(dx * dx + dy * dy) <= exit_error)
+		finished = true;
+
+	bool result = finished;
+	path_mutex.give();
+	return result;
+}
+
+int getPathSize() {
+	return size;
+}
+
+path_point_s_t getPathPoint(int index) {
+	path_mutex.take();
+	path_point_s_t point = path[std::max(0, std::min(index, size - 1))];
+	path_mutex.give();
+	return point;
+}
+
+Point getLookahead() {
+	path_mutex.take();
+	Point point = lookahead;
+	path_mutex.give();
+	return point;
+}
+
+void init(double min_lookahead, double max_lookahead, double spacing,
+          double smoothing, double turn_rate, double acceleration) {
+	pursuit::min_lookahead = min_lookahead;
+	pursuit::max_lookahead = max_lookahead;
+	pursuit::spacing = spacing;
+	pursuit::smoothing = smoothing;
+	pursuit::turn_rate = turn_rate;
+	pursuit::acceleration = acceleration;
+}
+
+} // namespace arms::pursuit
@@ -0,0 +1,198 @@
+#include "ARMS/api.h"
+#include "api.h"
+
+namespace arms::ramsete {
+
+#define MAX_TRAJECTORY_POINTS 512
+
+// lowest gain of the controller, so it still pulls the robot onto the end of
+// the trajectory once the reference has stopped
+#define MIN_GAIN 1 // 1/s
+
+// gains, the usual 2.0 and 0.7 with b converted from meters to inches
+double b = 0.00129;
+double zeta = 0.7;
+
+// trajectory generated from waypoints, and the one being tracked
+pursuit::path_point_s_t path[MAX_TRAJECTORY_POINTS];
+trajectory_point_s_t buffer[MAX_TRAJECTORY_POINTS];
+const trajectory_point_s_t* trajectory = nullptr;
+int size = 0;
+pros::Mutex trajectory_mutex;
+
+// tracking state
+uint32_t start_time = 0;
+int index = 0;
+trajectory_point_s_t target;
+
+// time the generated path, the heading comes from the spline table when there
+// is one and from the neighbouring points otherwise
+int timePath(int count, bool reverse, const path_sample_s_t* spline,
+             trajectory_point_s_t* out) {
+	if (count < 0)
+		return -1;
+
+	bake::time(path, count, reverse, spline, out);
+	return count;
+}
+
+int generate(std::vector<Point> waypoints, double max_velocity, bool reverse,
+             trajectory_point_s_t* out, int capacity) {
+	int count = pursuit::generate(waypoints, max_velocity, path,
+	                              std::min(capacity, MAX_TRAJECTORY_POINTS));
+	return timePath(count, reverse, nullptr, out);
+}
+
+int generate(const Path& path, double max_velocity, bool reverse,
+             trajectory_point_s_t* out, int capacity) {
+	int count =
+	    pursuit::generate(path, max_velocity, ramsete::path,
+	                      std::min(capacity, MAX_TRAJECTORY_POINTS));
+	return timePath(count, reverse, path.data(), out);
+}
+
+void start(const trajectory_point_s_t* trajectory, int size) {
+	trajectory_mutex.take();
+	ramsete::trajectory = trajectory;
+	ramsete::size = size;
+	start_time = pros::millis();
+	index = 0;
+	target = size > 0 ? trajectory[0] : trajectory_point_s_t();
+	trajectory_mutex.give();
+}
+
+// stop tracking before the buffer is overwritten
+void release() {
+	trajectory_mutex.take();
+	trajectory = nullptr;
+	size = 0;
+	trajectory_mutex.give();
+}
+
+bool start(std::vector<Point> waypoints, double max_velocity, bool reverse) {
+	if (waypoints.empty())
+		return false;
+
+	release();
+	waypoints.insert(waypoints.begin(), odom::getPosition());
+	int count = generate(waypoints, max_velocity, reverse, buffer,
+	                     MAX_TRAJECTORY_POINTS);
+	if (count < 0)
+		return false;
+
+	start(buffer, count);
+	return true;
+}
+
+bool start(const Path& path, double max_velocity, bool reverse) {
+	release();
+	int count =
+	    generate(path, max_velocity, reverse, buffer, MAX_TRAJECTORY_POINTS);
+	if (count < 0)
+		return false;
+
+	start(buffer, count);
+	return true;
+}
+
+// state of the trajectory at a time, interpolated between the points
+trajectory_point_s_t sample(double t) {
+	if (t >= trajectory[size - 1].time) {
+		trajectory_point_s_t end = trajectory[size - 1];
+		end.time = t;
+		end.velocity = 0;
+		end.angular_velocity = 0;
+		end.acceleration = 0;
+		return end;
+	}
+
+	// time only moves forward, so the search picks up where it left off
+	while (index < size - 2 && trajectory[index + 1].time <= t)
+		index++;
+
+	const trajectory_point_s_t& a = trajectory[index];
+	const trajectory_point_s_t& c = trajectory[index + 1];
+	double span = c.time - a.time;
+	double s = span > 0 ? fmin(1, fmax(0, (t - a.time) / span)) : 0;
+	return {t,
+	        a.x + (c.x - a.x) * s,
+	        a.y + (c.y - a.y) * s,
+	        a.theta + (c.theta - a.theta) * s,
+	        a.velocity + (c.velocity - a.velocity) * s,
+	        a.angular_velocity + (c.angular_velocity - a.angular_velocity) * s,
+	        a.acceleration};
+}
+
+void update() {
+	trajectory_mutex.take();
+	if (trajectory == nullptr || size == 0) {
+		chassis::setReference({0, 0}, {0, 0});
+		trajectory_mutex.give();
+		return;
+	}
+
+	target = sample((pros::millis() - start_time) / 1000.0);
+	odom::Pose pose = odom::getPose();
+
+	// error in the robot frame
+	double c = cos(pose.theta);
+	double s = sin(pose.theta);
+	double dx = target.x - pose.x;
+	double dy = target.y - pose.y;
+	double forward_error = c * dx + s * dy;
+	double left_error = -s * dx + c * dy;
+	double angle_error = target.theta - pose.theta;
+	while (fabs(angle_error) > M_PI)
+		angle_error -= 2 * M_PI * angle_error / fabs(angle_error);
+
+	// ramsete control law, the gain grows with the reference speed
+	double vd = target.velocity;
+	double wd = target.angular_velocity;
+	double k = fmax(MIN_GAIN, 2 * zeta * sqrt(wd * wd + b * vd * vd));
+	double sinc =
+	    fabs(angle_error) < 1e-6 ? 1 : sin(angle_error) / angle_error;
+	double v = vd * cos(angle_error) + k * forward_error;
+	double w = wd + k * angle_error + b * vd * sinc * left_error;
+
+	double half_width = chassis::getDriveWidth() / 2;
+	chassis::setReference({v - w * half_width, v + w * half_width},
+	                      {target.acceleration, target.acceleration});
+	trajectory_mutex.give();
+}
+
+// whether the trajectory has time left, the caller holds trajectory_mutex
+bool running() {
+	return trajectory != nullptr && size > 0 &&
+	       (pros::millis() - start_time) / 1000.0 < trajectory[size - 1].time;
+}
+
+bool isRunning() {
+	trajectory_mutex.take();
+	bool result = running();
+	trajectory_mutex.give();
+	return result;
+}
+
+bool done(double exit_error) {
+	trajectory_mutex.take();
+	bool result = true;
+	if (running()) {
+		result = false;
+	} else if (trajectory != nullptr && size > 0) {
+		Point end = {trajectory[size - 1].x, trajectory[size - 1].y};
+		result = odom::getDistanceError(end) <= exit_error;
+	}
+	trajectory_mutex.give();
+	return result;
+}
+
+trajectory_point_s_t getTarget() {
+	return target;
+}
+
+void init(double b, double zeta) {
+	ramsete::b = b;
+	ramsete::zeta = zeta;
+}
+
+} // namespace arms::ramsete
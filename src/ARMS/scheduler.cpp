@@ -0,0 +1,122 @@
+#include "ARMS/api.h"
+#include "api.h"
+#include "pros/rtos.hpp"
+
+namespace arms {
+
+// weight of the newest sample in the filtered period and jitter
+#define STATS_FILTER 0.05
+
+void addTime(time_stats_s_t& stats, double time) {
+	if (stats.count == 0)
+		stats.average = time;
+	stats.average += (time - stats.average) * STATS_FILTER;
+	if (time > stats.max)
+		stats.max = time;
+	stats.count++;
+}
+
+void printStats(const char* name, loop_stats_s_t stats) {
+	printf("%s: period %.2fms, jitter %.2fms, max %.2fms, compute %.2fms "
+	       "(max %.2fms), overruns %u/%u\n",
+	       name, stats.period, stats.jitter, stats.max_period,
+	       stats.compute.average, stats.compute.max, (unsigned)stats.overruns,
+	       (unsigned)stats.iterations);
+
+	// only print the populated part of the histogram
+	int last = LOOP_HISTOGRAM_BINS - 1;
+	while (last > 0 && stats.histogram[last] == 0)
+		last--;
+	printf("%s: histogram", name);
+	for (int i = 0; i <= last; i++)
+		printf(" %dms:%u", i, (unsigned)stats.histogram[i]);
+	printf("\n");
+}
+
+void printStats(const char* name, time_stats_s_t stats) {
+	printf("%s: average %.3fms, max %.3fms, count %u\n", name, stats.average,
+	       stats.max, (unsigned)stats.count);
+}
+
+Scheduler::Scheduler(uint32_t period) : reset(false), seq(0) {
+	this->period = period > 0 ? period : 1;
+	prev_wake = 0;
+	prev_tick = 0;
+	started = false;
+}
+
+void Scheduler::setPeriod(uint32_t period) {
+	this->period = period > 0 ? period : 1;
+	resetStats();
+}
+
+uint32_t Scheduler::getPeriod() {
+	return period;
+}
+
+void Scheduler::wait() {
+	if (!started) {
+		prev_wake = pros::millis();
+		prev_tick = pros::micros();
+		started = true;
+	} else {
+		addTime(stats.compute, (pros::micros() - prev_tick) / 1000.0);
+	}
+
+	if (reset.exchange(false))
+		stats = loop_stats_s_t();
+
+	uint32_t now = pros::millis();
+	if (now - prev_wake >= period) {
+		// the deadline already passed, realign the schedule to now
+		stats.overruns++;
+		prev_wake = now;
+	} else {
+		pros::Task::delay_until(&prev_wake, period);
+	}
+
+	// measure the period that just elapsed
+	uint64_t tick = pros::micros();
+	double dt = (tick - prev_tick) / 1000.0;
+	prev_tick = tick;
+
+	if (stats.iterations == 0)
+		stats.period = dt;
+	stats.period += (dt - stats.period) * STATS_FILTER;
+	stats.jitter += (fabs(dt - period) - stats.jitter) * STATS_FILTER;
+	if (dt > stats.max_period)
+		stats.max_period = dt;
+	stats.iterations++;
+
+	int bin = (int)dt;
+	if (bin >= LOOP_HISTOGRAM_BINS)
+		bin = LOOP_HISTOGRAM_BINS - 1;
+	stats.histogram[bin]++;
+
+	publish();
+}
+
+void Scheduler::publish() {
+	seq.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	published = stats;
+	std::atomic_thread_fence(std::memory_order_release);
+	seq.fetch_add(1, std::memory_order_relaxed);
+}
+
+loop_stats_s_t Scheduler::getStats() {
+	// retry if the loop published while we were reading
+	while (true) {
+		uint32_t before = seq.load(std::memory_order_acquire);
+		loop_stats_s_t copy = published;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!(before & 1) && seq.load(std::memory_order_relaxed) == before)
+			return copy;
+	}
+}
+
+void Scheduler::resetStats() {
+	reset.store(true);
+}
+
+} // namespace arms